@@ -21,6 +21,39 @@
 #include <map>
 #include <set>
 #include <ctime>
+#include <cstdint>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <cerrno>
+#include <cstddef>
+#include <array>
+#include <filesystem>
+#include <string_view>
+#include <future>
+#include <limits>
+#include <cstdlib>
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#endif
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <linux/futex.h>
+#include <linux/io_uring.h>
+#endif
+
+// Инструментирование Queue (время пребывания, глубина). Включается у очереди
+// вызовом EnableMetrics; сборка с -DLB3_QUEUE_METRICS=0 убирает его полностью.
+#ifndef LB3_QUEUE_METRICS
+#define LB3_QUEUE_METRICS 1
+#endif
 
 // ==================== ВСПОМОГАТЕЛЬНЫЕ СТРУКТУРЫ ДАННЫХ ====================
 
@@ -97,7 +130,7 @@ private:
     std::time_t birthDate;
 
 public:
-    Person() : birthDate(0) {}
+    Person() : id{}, birthDate(0) {}
     
     Person(PersonID id, std::string first, std::string middle, std::string last, std::time_t birth)
         : id(id), firstName(std::move(first)), middleName(std::move(middle)), 
@@ -158,6 +191,91 @@ std::ostream& operator<<(std::ostream& os, FunctionPtr func) {
     return os;
 }
 
+// ==================== БИНАРНОЕ КОДИРОВАНИЕ ====================
+
+// Побайтовое представление элементов для файлов очередей. Тривиально копируемые
+// типы пишутся как есть, строки — длиной и байтами, Person — по полям.
+template <typename T, typename Enable = void>
+struct BinaryCodec;
+
+template <typename T>
+struct BinaryCodec<T, std::enable_if_t<std::is_trivially_copyable_v<T>>> {
+    static void Write(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    static bool Read(const char*& cursor, const char* end, T& value) {
+        if (end - cursor < static_cast<std::ptrdiff_t>(sizeof(T))) return false;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+};
+
+template <>
+struct BinaryCodec<std::string> {
+    static void Write(std::string& out, const std::string& value) {
+        BinaryCodec<std::uint32_t>::Write(out, static_cast<std::uint32_t>(value.size()));
+        out.append(value);
+    }
+
+    static bool Read(const char*& cursor, const char* end, std::string& value) {
+        std::uint32_t size = 0;
+        if (!BinaryCodec<std::uint32_t>::Read(cursor, end, size)) return false;
+        if (end - cursor < static_cast<std::ptrdiff_t>(size)) return false;
+        value.assign(cursor, size);
+        cursor += size;
+        return true;
+    }
+};
+
+template <>
+struct BinaryCodec<Person> {
+    static void Write(std::string& out, const Person& value) {
+        BinaryCodec<PersonID>::Write(out, value.GetID());
+        BinaryCodec<std::string>::Write(out, value.GetFirstName());
+        BinaryCodec<std::string>::Write(out, value.GetMiddleName());
+        BinaryCodec<std::string>::Write(out, value.GetLastName());
+        BinaryCodec<std::int64_t>::Write(out, static_cast<std::int64_t>(value.GetBirthDate()));
+    }
+
+    static bool Read(const char*& cursor, const char* end, Person& value) {
+        PersonID id{};
+        std::string first, middle, last;
+        std::int64_t birth = 0;
+        if (!BinaryCodec<PersonID>::Read(cursor, end, id) ||
+            !BinaryCodec<std::string>::Read(cursor, end, first) ||
+            !BinaryCodec<std::string>::Read(cursor, end, middle) ||
+            !BinaryCodec<std::string>::Read(cursor, end, last) ||
+            !BinaryCodec<std::int64_t>::Read(cursor, end, birth)) {
+            return false;
+        }
+        value = Person(id, std::move(first), std::move(middle), std::move(last), static_cast<std::time_t>(birth));
+        return true;
+    }
+};
+
+// CRC-32 (IEEE 802.3), табличный вариант
+inline std::uint32_t Crc32(const char* data, std::size_t size, std::uint32_t crc = 0) {
+    static const auto table = []() {
+        std::array<std::uint32_t, 256> result{};
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+            }
+            result[i] = value;
+        }
+        return result;
+    }();
+
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
 // ==================== БАЗОВЫЙ ИНТЕРФЕЙС ПОСЛЕДОВАТЕЛЬНОСТИ ====================
 
 template <typename T>
@@ -180,11 +298,36 @@ public:
     virtual void Remove(const T& item) = 0;
     virtual void Clear() = 0;
 
+    // Групповые методы над непрерывным диапазоном [first, last). Реализации по
+    // умолчанию поэлементные; контейнеры переопределяют их одним резервированием
+    // и одним сдвигом хвоста на весь диапазон.
+    virtual void AppendRange(const T* first, const T* last) {
+        InsertRange(GetLength(), first, last);
+    }
+
+    virtual void InsertRange(int index, const T* first, const T* last) {
+        if (index < 0 || index > GetLength())
+            throw std::out_of_range("Index out of range");
+        for (; first != last; ++first) {
+            InsertAt(*first, index++);
+        }
+    }
+
+    virtual void RemoveRange(int start, int count) {
+        if (start < 0 || count < 0 || start + count > GetLength())
+            throw std::out_of_range("Invalid indices");
+        for (int i = 0; i < count; i++) {
+            RemoveAt(start);
+        }
+    }
+
     // Функциональные методы
     virtual std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const = 0;
     virtual std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const = 0;
     virtual std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const = 0;
     virtual T Reduce(std::function<T(T, T)> func, T initial) const = 0;
+    // Обход по порядку за один проход, без копий элементов
+    virtual void ForEach(const std::function<void(const T&)>& visit) const = 0;
     
     // Дополнительные операции
     virtual std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const = 0;
@@ -203,57 +346,485 @@ public:
     virtual std::string ToString() const = 0;
 };
 
+// ==================== БИНАРНЫЙ СНИМОК ====================
+
+// Формат снимка последовательности, версия 1 (порядок байт — как в памяти):
+//   SnapshotHeader
+//   SNAPSHOT_RAW:     T[count] — для тривиально копируемых T
+//   SNAPSHOT_OFFSETS: uint64 offsets[count + 1], затем blob; элемент i занимает
+//                     blob[offsets[i], offsets[i + 1]). std::string хранится
+//                     байтами как есть, прочие типы — через BinaryCodec<T>.
+constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+constexpr std::uint32_t SNAPSHOT_RAW = 0;
+constexpr std::uint32_t SNAPSHOT_OFFSETS = 1;
+
+struct SnapshotHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t layout;
+    std::uint32_t elementSize;
+    std::uint64_t count;
+    std::uint64_t payloadBytes;
+};
+
+// count из заголовка должен уместиться в payloadBytes и в int: иначе count * sizeof(T)
+// или (count + 1) * 8 переполняются и проверки размера проходят у подделанного файла
+inline bool SnapshotCountFits(const SnapshotHeader& header, std::size_t elementSize) {
+    if (header.count > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) return false;
+    if (header.layout == SNAPSHOT_OFFSETS) {
+        return header.count < header.payloadBytes / sizeof(std::uint64_t);
+    }
+    return header.count <= header.payloadBytes / elementSize;
+}
+
+// Кодирует снимок и отдаёт байты кусками: sink(const char* data, std::size_t size)
+template <typename T, typename Sink>
+void EncodeBinarySnapshot(const Sequence<T>& items, Sink&& sink) {
+    const std::uint64_t count = static_cast<std::uint64_t>(items.GetLength());
+    SnapshotHeader header{{'L', 'B', '3', 'S'}, SNAPSHOT_VERSION, SNAPSHOT_RAW, sizeof(T), count, 0};
+
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        header.payloadBytes = count * sizeof(T);
+        sink(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const std::size_t CHUNK_BYTES = 1 << 20;
+        std::string chunk;
+        chunk.reserve(CHUNK_BYTES + sizeof(T));
+        items.ForEach([&](const T& item) {
+            BinaryCodec<T>::Write(chunk, item);
+            if (chunk.size() >= CHUNK_BYTES) {
+                sink(chunk.data(), chunk.size());
+                chunk.clear();
+            }
+        });
+        sink(chunk.data(), chunk.size());
+    } else {
+        std::vector<std::uint64_t> offsets(count + 1);
+        std::string blob;
+        std::uint64_t index = 0;
+        items.ForEach([&](const T& item) {
+            offsets[index++] = blob.size();
+            if constexpr (std::is_same_v<T, std::string>) {
+                blob.append(item);
+            } else {
+                BinaryCodec<T>::Write(blob, item);
+            }
+        });
+        offsets[count] = blob.size();
+
+        header.layout = SNAPSHOT_OFFSETS;
+        header.payloadBytes = offsets.size() * sizeof(std::uint64_t) + blob.size();
+        sink(reinterpret_cast<const char*>(&header), sizeof(header));
+        sink(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(std::uint64_t));
+        sink(blob.data(), blob.size());
+    }
+}
+
+template <typename T>
+void WriteBinarySnapshot(const std::string& filename, const Sequence<T>& items) {
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    if (!file) throw std::runtime_error("Cannot open " + filename);
+    EncodeBinarySnapshot(items, [&](const char* data, std::size_t size) {
+        file.write(data, static_cast<std::streamsize>(size));
+    });
+    if (!file) throw std::runtime_error("Write failed: " + filename);
+}
+
+#if defined(__linux__)
+
+// Снимок, отображённый в память через mmap. Элементы не копируются: для
+// тривиально копируемых T Get возвращает ссылку в файл, для строк — string_view
+// на blob; прочие типы декодируются при обращении.
+template <typename T>
+class SnapshotView {
+private:
+    int fd = -1;
+    void* memory = nullptr;
+    std::size_t size = 0;
+    std::uint64_t count = 0;
+    const char* payload = nullptr;
+    const std::uint64_t* offsets = nullptr;
+    const char* blob = nullptr;
+    std::uint64_t blobBytes = 0;
+
+    void Fail(const std::string& message) {
+        if (memory && memory != MAP_FAILED) munmap(memory, size);
+        if (fd >= 0) close(fd);
+        throw std::runtime_error(message);
+    }
+
+public:
+    explicit SnapshotView(const std::string& filename) {
+        fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) throw std::runtime_error("open " + filename + ": " + std::strerror(errno));
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) Fail("fstat " + filename + ": " + std::strerror(errno));
+        size = static_cast<std::size_t>(info.st_size);
+        if (size < sizeof(SnapshotHeader)) Fail("Not a snapshot: " + filename);
+
+        memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (memory == MAP_FAILED) Fail("mmap " + filename + ": " + std::strerror(errno));
+        madvise(memory, size, MADV_SEQUENTIAL);
+
+        SnapshotHeader header;
+        std::memcpy(&header, memory, sizeof(header));
+        if (std::memcmp(header.magic, "LB3S", 4) != 0 || header.version != SNAPSHOT_VERSION) {
+            Fail("Not a snapshot: " + filename);
+        }
+        if (header.payloadBytes != size - sizeof(SnapshotHeader)) Fail("Truncated snapshot: " + filename);
+
+        count = header.count;
+        payload = static_cast<const char*>(memory) + sizeof(SnapshotHeader);
+
+        // elementSize сверяется только для сырого массива: размер std::string зависит от ABI
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (header.layout != SNAPSHOT_RAW || header.elementSize != sizeof(T)) {
+                Fail("Snapshot does not hold this element type: " + filename);
+            }
+            if (!SnapshotCountFits(header, sizeof(T)) || header.payloadBytes != count * sizeof(T)) {
+                Fail("Corrupted snapshot: " + filename);
+            }
+        } else {
+            if (header.layout != SNAPSHOT_OFFSETS) Fail("Snapshot does not hold this element type: " + filename);
+            if (!SnapshotCountFits(header, sizeof(T))) Fail("Corrupted snapshot: " + filename);
+            std::uint64_t offsetBytes = (count + 1) * sizeof(std::uint64_t);
+            offsets = reinterpret_cast<const std::uint64_t*>(payload);
+            blob = payload + offsetBytes;
+            blobBytes = header.payloadBytes - offsetBytes;
+            if (offsets[0] != 0 || offsets[count] != blobBytes) Fail("Corrupted snapshot: " + filename);
+        }
+    }
+
+    ~SnapshotView() {
+        munmap(memory, size);
+        close(fd);
+    }
+
+    SnapshotView(const SnapshotView<T>&) = delete;
+    SnapshotView<T>& operator=(const SnapshotView<T>&) = delete;
+
+    int GetLength() const { return static_cast<int>(count); }
+
+    const T* Data() const {
+        static_assert(std::is_trivially_copyable_v<T>, "Data() is available for trivially copyable T only");
+        return reinterpret_cast<const T*>(payload);
+    }
+
+    decltype(auto) Get(int index) const {
+        if (index < 0 || static_cast<std::uint64_t>(index) >= count)
+            throw std::out_of_range("Index out of range");
+
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            return Data()[index];
+        } else {
+            std::uint64_t begin = offsets[index];
+            std::uint64_t end = offsets[index + 1];
+            if (begin > end || end > blobBytes) throw std::runtime_error("Corrupted snapshot item");
+
+            if constexpr (std::is_same_v<T, std::string>) {
+                return std::string_view(blob + begin, end - begin);
+            } else {
+                T item;
+                const char* cursor = blob + begin;
+                if (!BinaryCodec<T>::Read(cursor, blob + end, item)) {
+                    throw std::runtime_error("Corrupted snapshot item");
+                }
+                return item;
+            }
+        }
+    }
+};
+
+#endif
+
 // ==================== ДИНАМИЧЕСКИЙ МАССИВ ====================
 
+// Встроенный буфер на InlineCapacity элементов; при нулевой ёмкости места не занимает
+template <typename T, int InlineCapacity>
+struct InlineStorage {
+    alignas(T) unsigned char bytes[sizeof(T) * InlineCapacity];
+};
+
 template <typename T>
+struct InlineStorage<T, 0> {};
+
+// InlineCapacity > 0 — оптимизация малого буфера: первые элементы живут внутри
+// объекта, куча используется только после переполнения встроенного буфера
+template <typename T, int InlineCapacity = 0>
 class ArraySequence : public Sequence<T> {
+    static_assert(InlineCapacity >= 0, "Inline capacity must be non-negative");
+
 private:
-    std::unique_ptr<T[]> data;
+    // Сырой буфер: сконструированы только первые length ячеек
+    T* data;
     int capacity;
     int length;
+    [[no_unique_address]] InlineStorage<T, InlineCapacity> inlineStorage;
+
+    T* InlineData() {
+        if constexpr (InlineCapacity > 0) {
+            return reinterpret_cast<T*>(inlineStorage.bytes);
+        } else {
+            return nullptr;
+        }
+    }
+
+    const T* InlineData() const {
+        if constexpr (InlineCapacity > 0) {
+            return reinterpret_cast<const T*>(inlineStorage.bytes);
+        } else {
+            return nullptr;
+        }
+    }
+
+    // Тривиально копируемые элементы переносятся побайтно: рост через realloc, сдвиги через memmove
+    static constexpr bool TRIVIAL_RELOCATION = std::is_trivially_copyable_v<T> && alignof(T) <= alignof(std::max_align_t);
+
+    // Крупные буферы таких элементов отображаются напрямую: mremap переносит
+    // таблицы страниц вместо копирования байтов и не удваивает занятую память
+    static constexpr std::size_t MAP_THRESHOLD_BYTES = std::size_t(32) << 20;
+
+    static std::size_t BytesFor(int count) {
+        return sizeof(T) * static_cast<std::size_t>(count);
+    }
+
+    static bool UsesMapping(int count) {
+#if defined(__linux__)
+        return TRIVIAL_RELOCATION && BytesFor(count) >= MAP_THRESHOLD_BYTES;
+#else
+        (void)count;
+        return false;
+#endif
+    }
+
+    static T* Allocate(int count) {
+        if (count <= 0) return nullptr;
+        if constexpr (TRIVIAL_RELOCATION) {
+#if defined(__linux__)
+            if (UsesMapping(count)) {
+                void* memory = mmap(nullptr, BytesFor(count), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (memory == MAP_FAILED) throw std::bad_alloc();
+                return static_cast<T*>(memory);
+            }
+#endif
+            void* memory = std::malloc(BytesFor(count));
+            if (memory == nullptr) throw std::bad_alloc();
+            return static_cast<T*>(memory);
+        } else {
+            return std::allocator<T>().allocate(static_cast<std::size_t>(count));
+        }
+    }
+
+    // Меняет размер буфера без поэлементного переноса; nullptr — если меняется способ выделения
+    static T* Reallocate(T* buffer, int oldCount, int newCount) {
+        if (UsesMapping(oldCount) != UsesMapping(newCount)) return nullptr;
+#if defined(__linux__)
+        if (UsesMapping(newCount)) {
+            void* memory = mremap(static_cast<void*>(buffer), BytesFor(oldCount), BytesFor(newCount), MREMAP_MAYMOVE);
+            if (memory == MAP_FAILED) throw std::bad_alloc();
+            return static_cast<T*>(memory);
+        }
+#endif
+        void* memory = std::realloc(static_cast<void*>(buffer), BytesFor(newCount));
+        if (memory == nullptr) throw std::bad_alloc();
+        return static_cast<T*>(memory);
+    }
+
+    void Deallocate(T* buffer, int count) {
+        if (buffer == nullptr || buffer == InlineData()) return;
+        if constexpr (TRIVIAL_RELOCATION) {
+#if defined(__linux__)
+            if (UsesMapping(count)) {
+                munmap(static_cast<void*>(buffer), BytesFor(count));
+                return;
+            }
+#endif
+            std::free(buffer);
+        } else {
+            std::allocator<T>().deallocate(buffer, static_cast<std::size_t>(count));
+        }
+    }
+
+    // Выбирает буфер под count элементов: встроенный, если помещаются
+    void Acquire(int count) {
+        if (InlineCapacity > 0 && count <= InlineCapacity) {
+            data = InlineData();
+            capacity = InlineCapacity;
+        } else {
+            data = Allocate(count);
+            capacity = std::max(count, 0);
+        }
+    }
+
+    void Release() {
+        std::destroy(data, data + length);
+        Deallocate(data, capacity);
+        data = InlineData();
+        capacity = InlineCapacity;
+        length = 0;
+    }
+
+    // Забирает содержимое other: кучу — указателем, встроенный буфер — поэлементно
+    void TakeFrom(ArraySequence& other) {
+        if (other.data != nullptr && other.data == other.InlineData()) {
+            data = InlineData();
+            capacity = InlineCapacity;
+            std::uninitialized_move(other.data, other.data + other.length, data);
+            length = other.length;
+            other.Clear();
+        } else {
+            data = other.data;
+            capacity = other.capacity;
+            length = other.length;
+            other.data = other.InlineData();
+            other.capacity = InlineCapacity;
+            other.length = 0;
+        }
+    }
 
+    // Переносит элементы в новый буфер: перемещением, если оно не бросает, иначе копией.
+    // Ёмкость не больше встроенной возвращает элементы во встроенный буфер
     void Resize(int newCapacity) {
-        std::unique_ptr<T[]> newData = std::make_unique<T[]>(newCapacity);
-        for (int i = 0; i < length; i++) {
-            newData[i] = std::move(data[i]);
+        bool toInline = InlineCapacity > 0 && newCapacity <= InlineCapacity;
+        if constexpr (TRIVIAL_RELOCATION) {
+            if (!toInline && newCapacity > 0 && data != nullptr && data != InlineData()) {
+                if (T* moved = Reallocate(data, capacity, newCapacity)) {
+                    data = moved;
+                    capacity = newCapacity;
+                    return;
+                }
+            }
         }
-        data = std::move(newData);
-        capacity = newCapacity;
+        T* newData = toInline ? InlineData() : Allocate(newCapacity);
+        try {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+                std::uninitialized_move(data, data + length, newData);
+            } else {
+                std::uninitialized_copy(data, data + length, newData);
+            }
+        } catch (...) {
+            Deallocate(newData, newCapacity);
+            throw;
+        }
+        std::destroy(data, data + length);
+        Deallocate(data, capacity);
+        data = newData;
+        capacity = toInline ? InlineCapacity : newCapacity;
+    }
+
+    void Grow() {
+        Resize(capacity > 0 ? capacity * 2 : 1);
+    }
+
+    // Место ещё под count элементов; удвоение сохраняет амортизированную оценку
+    void ReserveFor(int count) {
+        if (length + count > capacity) {
+            Resize(std::max(length + count, capacity * 2));
+        }
+    }
+
+    bool Overlaps(const T* first) const {
+        return std::less_equal<const T*>()(data, first) && std::less<const T*>()(first, data + length);
     }
 
 public:
-    ArraySequence() : data(std::make_unique<T[]>(1)), capacity(1), length(0) {}
+    ArraySequence() : length(0) {
+        Acquire(1);
+    }
     
-    ArraySequence(int initialCapacity) : data(std::make_unique<T[]>(initialCapacity)), 
-                                        capacity(initialCapacity), length(0) {}
+    ArraySequence(int initialCapacity) : length(0) {
+        Acquire(initialCapacity);
+    }
     
-    ArraySequence(std::initializer_list<T> init) : data(std::make_unique<T[]>(init.size())), 
-                                                  capacity(init.size()), length(init.size()) {
-        int i = 0;
-        for (const T& item : init) {
-            data[i++] = item;
+    ArraySequence(std::initializer_list<T> init) : length(0) {
+        Acquire(static_cast<int>(init.size()));
+        try {
+            std::uninitialized_copy(init.begin(), init.end(), data);
+        } catch (...) {
+            Deallocate(data, capacity);
+            throw;
         }
+        length = static_cast<int>(init.size());
     }
     
-    ArraySequence(const ArraySequence<T>& other) : data(std::make_unique<T[]>(other.capacity)), 
-                                                  capacity(other.capacity), length(other.length) {
-        for (int i = 0; i < length; i++) {
-            data[i] = other.data[i];
+    ArraySequence(const ArraySequence& other) : length(0) {
+        Acquire(other.capacity);
+        try {
+            std::uninitialized_copy(other.data, other.data + other.length, data);
+        } catch (...) {
+            Deallocate(data, capacity);
+            throw;
+        }
+        length = other.length;
+    }
+
+    ArraySequence(ArraySequence&& other) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<T>) {
+        TakeFrom(other);
+    }
+
+    ~ArraySequence() override {
+        Release();
+    }
+
+    ArraySequence& operator=(const ArraySequence& other) {
+        if (this != &other) {
+            ArraySequence copy(other);
+            *this = std::move(copy);
         }
+        return *this;
     }
 
-    ArraySequence<T>& operator=(const ArraySequence<T>& other) {
+    ArraySequence& operator=(ArraySequence&& other) noexcept(InlineCapacity == 0 || std::is_nothrow_move_constructible_v<T>) {
         if (this != &other) {
-            data = std::make_unique<T[]>(other.capacity);
-            capacity = other.capacity;
-            length = other.length;
-            for (int i = 0; i < length; i++) {
-                data[i] = other.data[i];
-            }
+            Release();
+            TakeFrom(other);
         }
         return *this;
     }
 
+    int GetCapacity() const {
+        return capacity;
+    }
+
+    bool IsInline() const {
+        return InlineCapacity > 0 && data == InlineData();
+    }
+
+    bool IsMapped() const {
+        return data != nullptr && data != InlineData() && UsesMapping(capacity);
+    }
+
+    const T* Data() const {
+        return data;
+    }
+
+    void Reserve(int newCapacity) {
+        if (newCapacity > capacity) {
+            Resize(newCapacity);
+        }
+    }
+
+    void ShrinkToFit() {
+        if (capacity > length && !IsInline()) {
+            Resize(length);
+        }
+    }
+
+    // Конструирует элемент прямо в буфере; аргументы могут ссылаться на элементы
+    // самой последовательности, поэтому при росте значение создаётся до переноса
+    template <typename... Args>
+    T& Emplace(Args&&... args) {
+        if (length >= capacity) {
+            T value(std::forward<Args>(args)...);
+            Grow();
+            ::new (static_cast<void*>(data + length)) T(std::move(value));
+        } else {
+            ::new (static_cast<void*>(data + length)) T(std::forward<Args>(args)...);
+        }
+        return data[length++];
+    }
+
     // Реализация методов Sequence<T>
     T GetFirst() const override {
         if (length == 0) throw std::out_of_range("Sequence is empty");
@@ -287,10 +858,11 @@ public:
     }
 
     void Append(const T& item) override {
-        if (length >= capacity) {
-            Resize(capacity * 2);
-        }
-        data[length++] = item;
+        Emplace(item);
+    }
+
+    void Append(T&& item) {
+        Emplace(std::move(item));
     }
 
     void Prepend(const T& item) override {
@@ -300,28 +872,94 @@ public:
     void InsertAt(const T& item, int index) override {
         if (index < 0 || index > length)
             throw std::out_of_range("Index out of range");
-        
+        if (index == length) {
+            Emplace(item);
+            return;
+        }
+
+        T value(item);
         if (length >= capacity) {
-            Resize(capacity * 2);
+            Grow();
         }
-        
-        for (int i = length; i > index; i--) {
-            data[i] = data[i - 1];
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::memmove(static_cast<void*>(data + index + 1), static_cast<const void*>(data + index),
+                         sizeof(T) * static_cast<std::size_t>(length - index));
+            ::new (static_cast<void*>(data + index)) T(std::move(value));
+            length++;
+            return;
         }
-        data[index] = item;
+        // Последняя ячейка ещё не сконструирована: её создаём, остальные сдвигаем присваиванием
+        ::new (static_cast<void*>(data + length)) T(std::move(data[length - 1]));
         length++;
+        std::move_backward(data + index, data + length - 2, data + length - 1);
+        data[index] = std::move(value);
     }
 
     void RemoveAt(int index) override {
         if (index < 0 || index >= length)
             throw std::out_of_range("Index out of range");
         
-        for (int i = index; i < length - 1; i++) {
-            data[i] = data[i + 1];
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::memmove(static_cast<void*>(data + index), static_cast<const void*>(data + index + 1),
+                         sizeof(T) * static_cast<std::size_t>(length - index - 1));
+        } else {
+            std::move(data + index + 1, data + length, data + index);
+            std::destroy_at(data + length - 1);
         }
         length--;
     }
 
+    // Хвост сдвигается один раз на весь диапазон: O(N + k) вместо O(k·N)
+    void InsertRange(int index, const T* first, const T* last) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+        int count = static_cast<int>(last - first);
+        if (count <= 0) return;
+        // Диапазон из самой последовательности испортится при росте или сдвиге
+        if (Overlaps(first)) {
+            ArraySequence<T> items(count);
+            items.AppendRange(first, last);
+            InsertRange(index, items.Data(), items.Data() + count);
+            return;
+        }
+
+        ReserveFor(count);
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::memmove(static_cast<void*>(data + index + count), static_cast<const void*>(data + index),
+                         sizeof(T) * static_cast<std::size_t>(length - index));
+            std::uninitialized_copy(first, last, data + index);
+        } else {
+            // За конец массива уходит часть хвоста или часть диапазона — эти ячейки
+            // конструируются, остальные присваиваются
+            int tail = length - index;
+            if (tail >= count) {
+                std::uninitialized_move(data + length - count, data + length, data + length);
+                std::move_backward(data + index, data + length - count, data + length);
+                std::copy(first, last, data + index);
+            } else {
+                std::uninitialized_copy(first + tail, last, data + length);
+                std::uninitialized_move(data + index, data + length, data + index + count);
+                std::copy(first, first + tail, data + index);
+            }
+        }
+        length += count;
+    }
+
+    void RemoveRange(int start, int count) override {
+        if (start < 0 || count < 0 || start + count > length)
+            throw std::out_of_range("Invalid indices");
+        if (count == 0) return;
+
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::memmove(static_cast<void*>(data + start), static_cast<const void*>(data + start + count),
+                         sizeof(T) * static_cast<std::size_t>(length - start - count));
+        } else {
+            std::move(data + start + count, data + length, data + start);
+            std::destroy(data + length - count, data + length);
+        }
+        length -= count;
+    }
+
     void Remove(const T& item) override {
         int index = IndexOf(item);
         if (index != -1) {
@@ -330,11 +968,15 @@ public:
     }
 
     void Clear() override {
+        std::destroy(data, data + length);
         length = 0;
     }
 
     std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const override {
-        auto result = std::make_shared<ArraySequence<T>>(*this);
+        auto result = std::make_shared<ArraySequence<T>>(length + other.GetLength());
+        for (int i = 0; i < length; i++) {
+            result->Append(data[i]);
+        }
         for (int i = 0; i < other.GetLength(); i++) {
             result->Append(other.Get(i));
         }
@@ -367,6 +1009,12 @@ public:
         return result;
     }
 
+    void ForEach(const std::function<void(const T&)>& visit) const override {
+        for (int i = 0; i < length; i++) {
+            visit(data[i]);
+        }
+    }
+
     std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
         int minLength = std::min(length, other.GetLength());
         auto result = std::make_shared<ArraySequence<T>>(minLength * 2);
@@ -453,8 +1101,34 @@ public:
         ss << "]";
         return ss.str();
     }
+
+    void SerializeBinary(const std::string& filename) const {
+        WriteBinarySnapshot(filename, *this);
+    }
+
+#if defined(__linux__)
+    // Заменяет содержимое снимком; тривиально копируемые элементы — одним memcpy
+    void DeserializeBinary(const std::string& filename) {
+        SnapshotView<T> view(filename);
+        int count = view.GetLength();
+        Clear();
+        Reserve(count);
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            std::memcpy(static_cast<void*>(data), view.Data(), static_cast<std::size_t>(count) * sizeof(T));
+            length = count;
+        } else {
+            for (int i = 0; i < count; i++) {
+                Emplace(view.Get(i));
+            }
+        }
+    }
+#endif
 };
 
+// Короткие последовательности без обращений к куче
+template <typename T, int InlineCapacity = 16>
+using SmallArraySequence = ArraySequence<T, InlineCapacity>;
+
 // ==================== СВЯЗАННЫЙ СПИСОК ====================
 
 template <typename T>
@@ -470,6 +1144,17 @@ private:
     Node* tail;
     int length;
 
+    // Узел перед позицией index: nullptr для начала, tail для конца списка
+    Node* NodeBefore(int index) const {
+        if (index == 0) return nullptr;
+        if (index == length) return tail;
+        Node* current = head.get();
+        for (int i = 0; i < index - 1; i++) {
+            current = current->next.get();
+        }
+        return current;
+    }
+
 public:
     LinkedListSequence() : head(nullptr), tail(nullptr), length(0) {}
     
@@ -608,6 +1293,50 @@ public:
         length--;
     }
 
+    // Новые узлы собираются в отдельную цепочку и подвешиваются за один проход до index
+    void InsertRange(int index, const T* first, const T* last) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+        if (first == last) return;
+
+        std::unique_ptr<Node> chain = std::make_unique<Node>(*first);
+        Node* chainTail = chain.get();
+        int count = 1;
+        for (const T* item = first + 1; item != last; ++item, ++count) {
+            chainTail->next = std::make_unique<Node>(*item);
+            chainTail = chainTail->next.get();
+        }
+
+        Node* previous = NodeBefore(index);
+        std::unique_ptr<Node>& link = previous ? previous->next : head;
+        chainTail->next = std::move(link);
+        link = std::move(chain);
+        if (!chainTail->next) tail = chainTail;
+        length += count;
+    }
+
+    void RemoveRange(int start, int count) override {
+        if (start < 0 || count < 0 || start + count > length)
+            throw std::out_of_range("Invalid indices");
+        if (count == 0) return;
+
+        Node* previous = NodeBefore(start);
+        std::unique_ptr<Node>& link = previous ? previous->next : head;
+        std::unique_ptr<Node> removed = std::move(link);
+        Node* last = removed.get();
+        for (int i = 1; i < count; i++) {
+            last = last->next.get();
+        }
+        link = std::move(last->next);
+        if (!link) tail = previous;
+        length -= count;
+
+        // Вырезанная цепочка разрушается по одному узлу, без рекурсии в деструкторах
+        while (removed) {
+            removed = std::move(removed->next);
+        }
+    }
+
     void Remove(const T& item) override {
         int index = IndexOf(item);
         if (index != -1) {
@@ -661,6 +1390,12 @@ public:
         return result;
     }
 
+    void ForEach(const std::function<void(const T&)>& visit) const override {
+        for (Node* current = head.get(); current; current = current->next.get()) {
+            visit(current->data);
+        }
+    }
+
     std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
         int minLength = std::min(length, other.GetLength());
         auto result = std::make_shared<LinkedListSequence<T>>();
@@ -775,147 +1510,5073 @@ public:
     }
 };
 
-// ==================== ОЧЕРЕДЬ (ЦЕЛЕВОЙ АТД) ====================
+// ==================== КОЛЬЦЕВОЙ БУФЕР ====================
 
+// Растущий кольцевой буфер: Append/Prepend и удаление с любого конца за O(1),
+// доступ по индексу через смещение от head с переносом через границу массива.
 template <typename T>
-class Queue : public Sequence<T> {
+class RingBufferSequence : public Sequence<T> {
+private:
+    std::unique_ptr<T[]> data;
+    int capacity;
+    int head;
+    int length;
+
+    int PhysicalIndex(int index) const {
+        int pos = head + index;
+        return pos >= capacity ? pos - capacity : pos;
+    }
+
+    void Resize(int newCapacity) {
+        std::unique_ptr<T[]> newData = std::make_unique<T[]>(newCapacity);
+        for (int i = 0; i < length; i++) {
+            newData[i] = std::move(data[PhysicalIndex(i)]);
+        }
+        data = std::move(newData);
+        capacity = newCapacity;
+        head = 0;
+    }
+
+    void EnsureCapacity() {
+        if (length >= capacity) {
+            Resize(capacity * 2);
+        }
+    }
+
+public:
+    RingBufferSequence() : data(std::make_unique<T[]>(1)), capacity(1), head(0), length(0) {}
+
+    RingBufferSequence(int initialCapacity) : data(std::make_unique<T[]>(std::max(1, initialCapacity))),
+                                              capacity(std::max(1, initialCapacity)), head(0), length(0) {}
+
+    RingBufferSequence(std::initializer_list<T> init) : RingBufferSequence(static_cast<int>(init.size())) {
+        for (const T& item : init) {
+            data[length++] = item;
+        }
+    }
+
+    RingBufferSequence(const RingBufferSequence<T>& other) : data(std::make_unique<T[]>(other.capacity)),
+                                                            capacity(other.capacity), head(0), length(other.length) {
+        for (int i = 0; i < length; i++) {
+            data[i] = other.data[other.PhysicalIndex(i)];
+        }
+    }
+
+    RingBufferSequence<T>& operator=(const RingBufferSequence<T>& other) {
+        if (this != &other) {
+            data = std::make_unique<T[]>(other.capacity);
+            capacity = other.capacity;
+            head = 0;
+            length = other.length;
+            for (int i = 0; i < length; i++) {
+                data[i] = other.data[other.PhysicalIndex(i)];
+            }
+        }
+        return *this;
+    }
+
+    int GetCapacity() const { return capacity; }
+
+    T GetFirst() const override {
+        if (length == 0) throw std::out_of_range("Sequence is empty");
+        return data[head];
+    }
+
+    T GetLast() const override {
+        if (length == 0) throw std::out_of_range("Sequence is empty");
+        return data[PhysicalIndex(length - 1)];
+    }
+
+    T Get(int index) const override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return data[PhysicalIndex(index)];
+    }
+
+    std::shared_ptr<Sequence<T>> GetSubsequence(int startIndex, int endIndex) const override {
+        if (startIndex < 0 || endIndex >= length || startIndex > endIndex)
+            throw std::out_of_range("Invalid indices");
+
+        auto sub = std::make_shared<RingBufferSequence<T>>(endIndex - startIndex + 1);
+        for (int i = startIndex; i <= endIndex; i++) {
+            sub->Append(data[PhysicalIndex(i)]);
+        }
+        return sub;
+    }
+
+    int GetLength() const override {
+        return length;
+    }
+
+    void Append(const T& item) override {
+        EnsureCapacity();
+        data[PhysicalIndex(length)] = item;
+        length++;
+    }
+
+    void Prepend(const T& item) override {
+        EnsureCapacity();
+        head = (head == 0) ? capacity - 1 : head - 1;
+        data[head] = item;
+        length++;
+    }
+
+    // Сдвигается меньшая из двух частей, поэтому вставка у любого края — O(1)
+    void InsertAt(const T& item, int index) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+
+        EnsureCapacity();
+
+        if (index < length / 2) {
+            head = (head == 0) ? capacity - 1 : head - 1;
+            length++;
+            for (int i = 0; i < index; i++) {
+                data[PhysicalIndex(i)] = std::move(data[PhysicalIndex(i + 1)]);
+            }
+        } else {
+            for (int i = length; i > index; i--) {
+                data[PhysicalIndex(i)] = std::move(data[PhysicalIndex(i - 1)]);
+            }
+            length++;
+        }
+        data[PhysicalIndex(index)] = item;
+    }
+
+    void RemoveAt(int index) override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+
+        if (index < length / 2) {
+            for (int i = index; i > 0; i--) {
+                data[PhysicalIndex(i)] = std::move(data[PhysicalIndex(i - 1)]);
+            }
+            data[head] = T();
+            head = PhysicalIndex(1);
+        } else {
+            for (int i = index; i < length - 1; i++) {
+                data[PhysicalIndex(i)] = std::move(data[PhysicalIndex(i + 1)]);
+            }
+            data[PhysicalIndex(length - 1)] = T();
+        }
+        length--;
+    }
+
+    // Как и InsertAt, сдвигается меньшая часть, но сразу на весь диапазон
+    void InsertRange(int index, const T* first, const T* last) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+        int count = static_cast<int>(last - first);
+        if (count <= 0) return;
+        if (std::less_equal<const T*>()(data.get(), first) && std::less<const T*>()(first, data.get() + capacity)) {
+            ArraySequence<T> items(count);
+            items.AppendRange(first, last);
+            InsertRange(index, items.Data(), items.Data() + count);
+            return;
+        }
+
+        if (length + count > capacity) {
+            Resize(std::max(length + count, capacity * 2));
+        }
+        if (index < length - index) {
+            head = (head - count + capacity) % capacity;
+            for (int i = 0; i < index; i++) {
+                data[PhysicalIndex(i)] = std::move(data[PhysicalIndex(i + count)]);
+            }
+        } else {
+            for (int i = length - 1; i >= index; i--) {
+                data[PhysicalIndex(i + count)] = std::move(data[PhysicalIndex(i)]);
+            }
+        }
+        length += count;
+        for (int i = 0; i < count; i++) {
+            data[PhysicalIndex(index + i)] = first[i];
+        }
+    }
+
+    void RemoveRange(int start, int count) override {
+        if (start < 0 || count < 0 || start + count > length)
+            throw std::out_of_range("Invalid indices");
+        if (count == 0) return;
+
+        if (start < length - start - count) {
+            for (int i = start - 1; i >= 0; i--) {
+                data[PhysicalIndex(i + count)] = std::move(data[PhysicalIndex(i)]);
+            }
+            for (int i = 0; i < count; i++) {
+                data[PhysicalIndex(i)] = T();
+            }
+            head = PhysicalIndex(count);
+        } else {
+            for (int i = start; i < length - count; i++) {
+                data[PhysicalIndex(i)] = std::move(data[PhysicalIndex(i + count)]);
+            }
+            for (int i = length - count; i < length; i++) {
+                data[PhysicalIndex(i)] = T();
+            }
+        }
+        length -= count;
+    }
+
+    void Remove(const T& item) override {
+        int index = IndexOf(item);
+        if (index != -1) {
+            RemoveAt(index);
+        }
+    }
+
+    void Clear() override {
+        head = 0;
+        length = 0;
+    }
+
+    std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const override {
+        auto result = std::make_shared<RingBufferSequence<T>>(*this);
+        for (int i = 0; i < other.GetLength(); i++) {
+            result->Append(other.Get(i));
+        }
+        return result;
+    }
+
+    std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const override {
+        auto result = std::make_shared<RingBufferSequence<T>>(length);
+        for (int i = 0; i < length; i++) {
+            result->Append(func(data[PhysicalIndex(i)]));
+        }
+        return result;
+    }
+
+    std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const override {
+        auto result = std::make_shared<RingBufferSequence<T>>();
+        for (int i = 0; i < length; i++) {
+            const T& item = data[PhysicalIndex(i)];
+            if (predicate(item)) {
+                result->Append(item);
+            }
+        }
+        return result;
+    }
+
+    T Reduce(std::function<T(T, T)> func, T initial) const override {
+        T result = initial;
+        for (int i = 0; i < length; i++) {
+            result = func(result, data[PhysicalIndex(i)]);
+        }
+        return result;
+    }
+
+    void ForEach(const std::function<void(const T&)>& visit) const override {
+        for (int i = 0; i < length; i++) {
+            visit(data[PhysicalIndex(i)]);
+        }
+    }
+
+    std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
+        int minLength = std::min(length, other.GetLength());
+        auto result = std::make_shared<RingBufferSequence<T>>(minLength * 2);
+
+        for (int i = 0; i < minLength; i++) {
+            result->Append(data[PhysicalIndex(i)]);
+            result->Append(other.Get(i));
+        }
+        return result;
+    }
+
+    std::pair<std::shared_ptr<Sequence<T>>, std::shared_ptr<Sequence<T>>> Split(std::function<bool(T)> predicate) const override {
+        auto trueSeq = std::make_shared<RingBufferSequence<T>>();
+        auto falseSeq = std::make_shared<RingBufferSequence<T>>();
+
+        for (int i = 0; i < length; i++) {
+            const T& item = data[PhysicalIndex(i)];
+            if (predicate(item)) {
+                trueSeq->Append(item);
+            } else {
+                falseSeq->Append(item);
+            }
+        }
+
+        return {trueSeq, falseSeq};
+    }
+
+    std::shared_ptr<Sequence<T>> Slice(int start, int end) const override {
+        return GetSubsequence(start, end);
+    }
+
+    bool ContainsSubsequence(const Sequence<T>& subsequence) const override {
+        if (subsequence.GetLength() == 0) return true;
+        if (subsequence.GetLength() > length) return false;
+
+        for (int i = 0; i <= length - subsequence.GetLength(); i++) {
+            bool match = true;
+            for (int j = 0; j < subsequence.GetLength(); j++) {
+                if (data[PhysicalIndex(i + j)] != subsequence.Get(j)) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) return true;
+        }
+        return false;
+    }
+
+    T& operator[](int index) override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return data[PhysicalIndex(index)];
+    }
+
+    const T& operator[](int index) const override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return data[PhysicalIndex(index)];
+    }
+
+    bool Contains(const T& item) const override {
+        return IndexOf(item) != -1;
+    }
+
+    int IndexOf(const T& item) const override {
+        for (int i = 0; i < length; i++) {
+            if (data[PhysicalIndex(i)] == item) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool IsEmpty() const override {
+        return length == 0;
+    }
+
+    std::string ToString() const override {
+        std::stringstream ss;
+        ss << "[";
+        for (int i = 0; i < length; i++) {
+            ss << data[PhysicalIndex(i)];
+            if (i < length - 1) ss << ", ";
+        }
+        ss << "]";
+        return ss.str();
+    }
+};
+
+// ==================== ДВУСТОРОННИЙ МАССИВ ====================
+
+// Непрерывный массив с запасом с обеих сторон: элементы лежат в buffer[front … front + length).
+// Append и Prepend — амортизированное O(1); когда запас с одной стороны кончается,
+// элементы переносятся в середину буфера (вдвое большего, если он заполнен хотя бы
+// наполовину). Get — одно сложение смещения, обход идёт по памяти подряд.
+template <typename T>
+class DoubleEndedArraySequence : public Sequence<T> {
+private:
+    T* buffer;
+    int capacity;
+    int front;
+    int length;
+
+    T* Items() const {
+        return buffer + front;
+    }
+
+    static T* Allocate(int count) {
+        return count > 0 ? std::allocator<T>().allocate(static_cast<std::size_t>(count)) : nullptr;
+    }
+
+    static void Deallocate(T* memory, int count) {
+        if (memory != nullptr) std::allocator<T>().deallocate(memory, static_cast<std::size_t>(count));
+    }
+
+    void Release() {
+        std::destroy(Items(), Items() + length);
+        Deallocate(buffer, capacity);
+        buffer = nullptr;
+        capacity = 0;
+        front = 0;
+        length = 0;
+    }
+
+    // Переносит элементы в середину нового буфера
+    void Relocate(int newCapacity) {
+        T* newBuffer = Allocate(newCapacity);
+        int newFront = (newCapacity - length) / 2;
+        try {
+            if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+                std::uninitialized_move(Items(), Items() + length, newBuffer + newFront);
+            } else {
+                std::uninitialized_copy(Items(), Items() + length, newBuffer + newFront);
+            }
+        } catch (...) {
+            Deallocate(newBuffer, newCapacity);
+            throw;
+        }
+        std::destroy(Items(), Items() + length);
+        Deallocate(buffer, capacity);
+        buffer = newBuffer;
+        capacity = newCapacity;
+        front = newFront;
+    }
+
+    // Гарантирует count свободных ячеек с нужной стороны. Полупустой буфер только
+    // центрируется, иначе удваивается — так чередование Append и RemoveAt(0) не
+    // раздувает память, а рост с одного края остаётся амортизированно O(1)
+    void EnsureSpare(bool atFront, int count) {
+        int spare = atFront ? front : capacity - front - length;
+        if (spare >= count) return;
+        if (length == 0 && capacity >= 2 * count) {
+            front = capacity / 2;
+            return;
+        }
+        int newCapacity = length >= capacity / 2 ? capacity * 2 : capacity;
+        Relocate(std::max({newCapacity, length + 2 * count, 4}));
+    }
+
+    bool Overlaps(const T* first) const {
+        return std::less_equal<const T*>()(Items(), first) && std::less<const T*>()(first, Items() + length);
+    }
+
+public:
+    DoubleEndedArraySequence() : buffer(nullptr), capacity(0), front(0), length(0) {}
+
+    // Запас резервируется в конце, как у ArraySequence; первый Prepend в пустую
+    // последовательность сдвигает начало в середину без перевыделения
+    DoubleEndedArraySequence(int initialCapacity) : buffer(Allocate(initialCapacity)), capacity(std::max(initialCapacity, 0)),
+                                                    front(0), length(0) {}
+
+    DoubleEndedArraySequence(std::initializer_list<T> init) : DoubleEndedArraySequence(static_cast<int>(init.size())) {
+        InsertRange(0, init.begin(), init.end());
+    }
+
+    DoubleEndedArraySequence(const DoubleEndedArraySequence<T>& other) : DoubleEndedArraySequence(other.length) {
+        InsertRange(0, other.Items(), other.Items() + other.length);
+    }
+
+    DoubleEndedArraySequence(DoubleEndedArraySequence<T>&& other) noexcept
+        : buffer(other.buffer), capacity(other.capacity), front(other.front), length(other.length) {
+        other.buffer = nullptr;
+        other.capacity = 0;
+        other.front = 0;
+        other.length = 0;
+    }
+
+    ~DoubleEndedArraySequence() override {
+        Release();
+    }
+
+    DoubleEndedArraySequence<T>& operator=(const DoubleEndedArraySequence<T>& other) {
+        if (this != &other) {
+            DoubleEndedArraySequence<T> copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    DoubleEndedArraySequence<T>& operator=(DoubleEndedArraySequence<T>&& other) noexcept {
+        if (this != &other) {
+            Release();
+            buffer = other.buffer;
+            capacity = other.capacity;
+            front = other.front;
+            length = other.length;
+            other.buffer = nullptr;
+            other.capacity = 0;
+            other.front = 0;
+            other.length = 0;
+        }
+        return *this;
+    }
+
+    int GetCapacity() const { return capacity; }
+
+    const T* Data() const { return Items(); }
+
+    T GetFirst() const override {
+        if (length == 0) throw std::out_of_range("Sequence is empty");
+        return buffer[front];
+    }
+
+    T GetLast() const override {
+        if (length == 0) throw std::out_of_range("Sequence is empty");
+        return buffer[front + length - 1];
+    }
+
+    T Get(int index) const override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return buffer[front + index];
+    }
+
+    std::shared_ptr<Sequence<T>> GetSubsequence(int startIndex, int endIndex) const override {
+        if (startIndex < 0 || endIndex >= length || startIndex > endIndex)
+            throw std::out_of_range("Invalid indices");
+
+        auto sub = std::make_shared<DoubleEndedArraySequence<T>>(endIndex - startIndex + 1);
+        sub->AppendRange(Items() + startIndex, Items() + endIndex + 1);
+        return sub;
+    }
+
+    int GetLength() const override {
+        return length;
+    }
+
+    void Append(const T& item) override {
+        T value(item);
+        Append(std::move(value));
+    }
+
+    void Append(T&& item) {
+        EnsureSpare(false, 1);
+        ::new (static_cast<void*>(Items() + length)) T(std::move(item));
+        length++;
+    }
+
+    void Prepend(const T& item) override {
+        T value(item);
+        Prepend(std::move(value));
+    }
+
+    void Prepend(T&& item) {
+        EnsureSpare(true, 1);
+        ::new (static_cast<void*>(Items() - 1)) T(std::move(item));
+        front--;
+        length++;
+    }
+
+    void InsertAt(const T& item, int index) override {
+        T value(item);
+        InsertRange(index, &value, &value + 1);
+    }
+
+    // Удаление с любого края — O(1), в середине сдвигается меньшая часть
+    void RemoveAt(int index) override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        RemoveRange(index, 1);
+    }
+
+    // Раздвигается меньшая из двух частей; ячейки разрыва за старыми границами
+    // конструируются, внутри — присваиваются
+    void InsertRange(int index, const T* first, const T* last) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+        int count = static_cast<int>(last - first);
+        if (count <= 0) return;
+        if (Overlaps(first)) {
+            DoubleEndedArraySequence<T> items(count);
+            items.AppendRange(first, last);
+            InsertRange(index, items.Data(), items.Data() + count);
+            return;
+        }
+
+        bool atFront = index < length - index;
+        EnsureSpare(atFront, count);
+        T* items = Items();
+        int gapStart = index;
+        if (atFront) {
+            if (index >= count) {
+                std::uninitialized_move(items, items + count, items - count);
+                std::move(items + count, items + index, items);
+            } else {
+                std::uninitialized_move(items, items + index, items - count);
+            }
+            gapStart = index - count;
+        } else {
+            int tail = length - index;
+            if (tail >= count) {
+                std::uninitialized_move(items + length - count, items + length, items + length);
+                std::move_backward(items + index, items + length - count, items + length);
+            } else {
+                std::uninitialized_move(items + index, items + length, items + index + count);
+            }
+        }
+        for (int i = 0; i < count; i++) {
+            int position = gapStart + i;
+            if (position >= 0 && position < length) {
+                items[position] = first[i];
+            } else {
+                ::new (static_cast<void*>(items + position)) T(first[i]);
+            }
+        }
+        if (atFront) front -= count;
+        length += count;
+    }
+
+    void RemoveRange(int start, int count) override {
+        if (start < 0 || count < 0 || start + count > length)
+            throw std::out_of_range("Invalid indices");
+        if (count == 0) return;
+
+        T* items = Items();
+        if (start < length - start - count) {
+            std::move_backward(items, items + start, items + start + count);
+            std::destroy(items, items + count);
+            front += count;
+        } else {
+            std::move(items + start + count, items + length, items + start);
+            std::destroy(items + length - count, items + length);
+        }
+        length -= count;
+        if (length == 0) front = capacity / 2;
+    }
+
+    void Remove(const T& item) override {
+        int index = IndexOf(item);
+        if (index != -1) {
+            RemoveAt(index);
+        }
+    }
+
+    void Clear() override {
+        std::destroy(Items(), Items() + length);
+        length = 0;
+        front = capacity / 2;
+    }
+
+    std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const override {
+        auto result = std::make_shared<DoubleEndedArraySequence<T>>(*this);
+        for (int i = 0; i < other.GetLength(); i++) {
+            result->Append(other.Get(i));
+        }
+        return result;
+    }
+
+    std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const override {
+        auto result = std::make_shared<DoubleEndedArraySequence<T>>(length);
+        for (int i = 0; i < length; i++) {
+            result->Append(func(buffer[front + i]));
+        }
+        return result;
+    }
+
+    std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const override {
+        auto result = std::make_shared<DoubleEndedArraySequence<T>>();
+        for (int i = 0; i < length; i++) {
+            if (predicate(buffer[front + i])) {
+                result->Append(buffer[front + i]);
+            }
+        }
+        return result;
+    }
+
+    T Reduce(std::function<T(T, T)> func, T initial) const override {
+        T result = initial;
+        for (int i = 0; i < length; i++) {
+            result = func(result, buffer[front + i]);
+        }
+        return result;
+    }
+
+    void ForEach(const std::function<void(const T&)>& visit) const override {
+        for (int i = 0; i < length; i++) {
+            visit(buffer[front + i]);
+        }
+    }
+
+    std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
+        int minLength = std::min(length, other.GetLength());
+        auto result = std::make_shared<DoubleEndedArraySequence<T>>(minLength * 2);
+
+        for (int i = 0; i < minLength; i++) {
+            result->Append(buffer[front + i]);
+            result->Append(other.Get(i));
+        }
+        return result;
+    }
+
+    std::pair<std::shared_ptr<Sequence<T>>, std::shared_ptr<Sequence<T>>> Split(std::function<bool(T)> predicate) const override {
+        auto trueSeq = std::make_shared<DoubleEndedArraySequence<T>>();
+        auto falseSeq = std::make_shared<DoubleEndedArraySequence<T>>();
+
+        for (int i = 0; i < length; i++) {
+            const T& item = buffer[front + i];
+            if (predicate(item)) {
+                trueSeq->Append(item);
+            } else {
+                falseSeq->Append(item);
+            }
+        }
+
+        return {trueSeq, falseSeq};
+    }
+
+    std::shared_ptr<Sequence<T>> Slice(int start, int end) const override {
+        return GetSubsequence(start, end);
+    }
+
+    bool ContainsSubsequence(const Sequence<T>& subsequence) const override {
+        if (subsequence.GetLength() == 0) return true;
+        if (subsequence.GetLength() > length) return false;
+
+        for (int i = 0; i <= length - subsequence.GetLength(); i++) {
+            bool match = true;
+            for (int j = 0; j < subsequence.GetLength(); j++) {
+                if (buffer[front + i + j] != subsequence.Get(j)) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) return true;
+        }
+        return false;
+    }
+
+    T& operator[](int index) override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return buffer[front + index];
+    }
+
+    const T& operator[](int index) const override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return buffer[front + index];
+    }
+
+    bool Contains(const T& item) const override {
+        return IndexOf(item) != -1;
+    }
+
+    int IndexOf(const T& item) const override {
+        for (int i = 0; i < length; i++) {
+            if (buffer[front + i] == item) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool IsEmpty() const override {
+        return length == 0;
+    }
+
+    std::string ToString() const override {
+        std::stringstream ss;
+        ss << "[";
+        for (int i = 0; i < length; i++) {
+            ss << buffer[front + i];
+            if (i < length - 1) ss << ", ";
+        }
+        ss << "]";
+        return ss.str();
+    }
+};
+
+// ==================== D-АРНАЯ КУЧА ====================
+
+// Порядок очередей с приоритетом по умолчанию: меньший извлекается раньше.
+// Обычный поиск operator< находит и глобальный оператор для Complex (std::less — нет).
+template <typename T>
+bool DefaultBefore(const T& a, const T& b) {
+    return a < b;
+}
+
+// Куча с арностью ARITY в непрерывном массиве: потомки узла i — ARITY*i+1 … ARITY*i+ARITY.
+// Четыре потомка обычно лежат в одной кэш-линии, а высота вдвое меньше, чем у двоичной.
+// before(a, b) == true — a извлекается раньше b (по умолчанию меньший раньше).
+// GetFirst — вершина; Get, GetLast и ToString идут в порядке расположения в куче.
+// Любая вставка (Append, Prepend, InsertAt) кладёт элемент по приоритету, а не по индексу.
+template <typename T>
+class HeapSequence : public Sequence<T> {
+public:
+    using Compare = std::function<bool(const T&, const T&)>;
+    static constexpr int ARITY = 4;
+
+private:
+    std::unique_ptr<T[]> data;
+    int capacity;
+    int length;
+    Compare before;
+
+    void Resize(int newCapacity) {
+        std::unique_ptr<T[]> newData = std::make_unique<T[]>(newCapacity);
+        for (int i = 0; i < length; i++) {
+            newData[i] = std::move(data[i]);
+        }
+        data = std::move(newData);
+        capacity = newCapacity;
+    }
+
+    void SiftUp(int index) {
+        T item = std::move(data[index]);
+        while (index > 0) {
+            int parent = (index - 1) / ARITY;
+            if (!before(item, data[parent])) break;
+            data[index] = std::move(data[parent]);
+            index = parent;
+        }
+        data[index] = std::move(item);
+    }
+
+    void SiftDown(int index) {
+        T item = std::move(data[index]);
+        for (;;) {
+            int first = index * ARITY + 1;
+            if (first >= length) break;
+            int last = std::min(first + ARITY, length);
+            int best = first;
+            for (int child = first + 1; child < last; child++) {
+                if (before(data[child], data[best])) best = child;
+            }
+            if (!before(data[best], item)) break;
+            data[index] = std::move(data[best]);
+            index = best;
+        }
+        data[index] = std::move(item);
+    }
+
+    void Heapify() {
+        for (int i = (length - 2) / ARITY; i >= 0; i--) {
+            SiftDown(i);
+        }
+    }
+
+    // Пустая куча того же порядка, вместимостью не меньше reserve
+    std::shared_ptr<HeapSequence<T>> MakeEmpty(int reserve = 1) const {
+        return std::make_shared<HeapSequence<T>>(before, reserve);
+    }
+
+    // Добавление без восстановления свойства кучи — перед Heapify
+    void PushBack(const T& item) {
+        if (length >= capacity) Resize(capacity * 2);
+        data[length++] = item;
+    }
+
+public:
+    explicit HeapSequence(Compare before = DefaultBefore<T>, int initialCapacity = 1)
+        : data(std::make_unique<T[]>(std::max(1, initialCapacity))), capacity(std::max(1, initialCapacity)),
+          length(0), before(std::move(before)) {}
+
+    HeapSequence(std::initializer_list<T> init, Compare before = DefaultBefore<T>)
+        : HeapSequence(std::move(before), static_cast<int>(init.size())) {
+        for (const T& item : init) {
+            data[length++] = item;
+        }
+        Heapify();
+    }
+
+    HeapSequence(const HeapSequence<T>& other)
+        : data(std::make_unique<T[]>(other.capacity)), capacity(other.capacity), length(other.length),
+          before(other.before) {
+        for (int i = 0; i < length; i++) {
+            data[i] = other.data[i];
+        }
+    }
+
+    HeapSequence<T>& operator=(const HeapSequence<T>& other) {
+        if (this != &other) {
+            data = std::make_unique<T[]>(other.capacity);
+            capacity = other.capacity;
+            length = other.length;
+            before = other.before;
+            for (int i = 0; i < length; i++) {
+                data[i] = other.data[i];
+            }
+        }
+        return *this;
+    }
+
+    const Compare& GetComparator() const { return before; }
+
+    T GetFirst() const override {
+        if (length == 0) throw std::out_of_range("Sequence is empty");
+        return data[0];
+    }
+
+    T GetLast() const override {
+        if (length == 0) throw std::out_of_range("Sequence is empty");
+        return data[length - 1];
+    }
+
+    T Get(int index) const override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return data[index];
+    }
+
+    // Полный диапазон остаётся кучей как есть, частичный — перестраивается за O(k)
+    std::shared_ptr<Sequence<T>> GetSubsequence(int startIndex, int endIndex) const override {
+        if (startIndex < 0 || endIndex >= length || startIndex > endIndex)
+            throw std::out_of_range("Invalid indices");
+
+        auto sub = MakeEmpty(endIndex - startIndex + 1);
+        for (int i = startIndex; i <= endIndex; i++) {
+            sub->PushBack(data[i]);
+        }
+        if (startIndex > 0) sub->Heapify();
+        return sub;
+    }
+
+    int GetLength() const override {
+        return length;
+    }
+
+    void Append(const T& item) override {
+        PushBack(item);
+        SiftUp(length - 1);
+    }
+
+    void Prepend(const T& item) override {
+        Append(item);
+    }
+
+    void InsertAt(const T& item, int index) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+        Append(item);
+    }
+
+    // На место удалённого встаёт последний элемент и просеивается в нужную сторону
+    void RemoveAt(int index) override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+
+        length--;
+        if (index != length) {
+            data[index] = std::move(data[length]);
+            if (index > 0 && before(data[index], data[(index - 1) / ARITY])) {
+                SiftUp(index);
+            } else {
+                SiftDown(index);
+            }
+        }
+        data[length] = T();
+    }
+
+    // Крупный диапазон дешевле достроить Heapify за O(N + k), мелкий — просеять по одному
+    void InsertRange(int index, const T* first, const T* last) override {
+        if (index < 0 || index > length)
+            throw std::out_of_range("Index out of range");
+        int count = static_cast<int>(last - first);
+        if (count <= 0) return;
+        if (std::less_equal<const T*>()(data.get(), first) && std::less<const T*>()(first, data.get() + capacity)) {
+            ArraySequence<T> items(count);
+            items.AppendRange(first, last);
+            InsertRange(index, items.Data(), items.Data() + count);
+            return;
+        }
+
+        int oldLength = length;
+        if (length + count > capacity) {
+            Resize(std::max(length + count, capacity * 2));
+        }
+        for (const T* item = first; item != last; ++item) {
+            data[length++] = *item;
+        }
+        if (count > oldLength) {
+            Heapify();
+        } else {
+            for (int i = oldLength; i < length; i++) {
+                SiftUp(i);
+            }
+        }
+    }
+
+    // Позиции считаются в порядке расположения в куче; хвост кучи удаляется без перестройки
+    void RemoveRange(int start, int count) override {
+        if (start < 0 || count < 0 || start + count > length)
+            throw std::out_of_range("Invalid indices");
+        if (count == 0) return;
+
+        std::move(data.get() + start + count, data.get() + length, data.get() + start);
+        for (int i = length - count; i < length; i++) {
+            data[i] = T();
+        }
+        length -= count;
+        if (start < length) {
+            Heapify();
+        }
+    }
+
+    void Remove(const T& item) override {
+        int index = IndexOf(item);
+        if (index != -1) {
+            RemoveAt(index);
+        }
+    }
+
+    void Clear() override {
+        length = 0;
+    }
+
+    std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const override {
+        auto result = std::make_shared<HeapSequence<T>>(*this);
+        for (int i = 0; i < other.GetLength(); i++) {
+            result->PushBack(other.Get(i));
+        }
+        result->Heapify();
+        return result;
+    }
+
+    std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const override {
+        auto result = MakeEmpty(length);
+        for (int i = 0; i < length; i++) {
+            result->PushBack(func(data[i]));
+        }
+        result->Heapify();
+        return result;
+    }
+
+    // Подмножество кучи, взятое в порядке массива, не нарушает её свойства только
+    // для полного набора, поэтому результат перестраивается
+    std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const override {
+        auto result = MakeEmpty();
+        for (int i = 0; i < length; i++) {
+            if (predicate(data[i])) {
+                result->PushBack(data[i]);
+            }
+        }
+        result->Heapify();
+        return result;
+    }
+
+    T Reduce(std::function<T(T, T)> func, T initial) const override {
+        T result = initial;
+        for (int i = 0; i < length; i++) {
+            result = func(result, data[i]);
+        }
+        return result;
+    }
+
+    void ForEach(const std::function<void(const T&)>& visit) const override {
+        for (int i = 0; i < length; i++) {
+            visit(data[i]);
+        }
+    }
+
+    std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
+        int minLength = std::min(length, other.GetLength());
+        auto result = MakeEmpty(minLength * 2);
+
+        for (int i = 0; i < minLength; i++) {
+            result->PushBack(data[i]);
+            result->PushBack(other.Get(i));
+        }
+        result->Heapify();
+        return result;
+    }
+
+    std::pair<std::shared_ptr<Sequence<T>>, std::shared_ptr<Sequence<T>>> Split(std::function<bool(T)> predicate) const override {
+        auto trueSeq = MakeEmpty();
+        auto falseSeq = MakeEmpty();
+
+        for (int i = 0; i < length; i++) {
+            if (predicate(data[i])) {
+                trueSeq->PushBack(data[i]);
+            } else {
+                falseSeq->PushBack(data[i]);
+            }
+        }
+        trueSeq->Heapify();
+        falseSeq->Heapify();
+
+        return {trueSeq, falseSeq};
+    }
+
+    std::shared_ptr<Sequence<T>> Slice(int start, int end) const override {
+        return GetSubsequence(start, end);
+    }
+
+    bool ContainsSubsequence(const Sequence<T>& subsequence) const override {
+        if (subsequence.GetLength() == 0) return true;
+        if (subsequence.GetLength() > length) return false;
+
+        for (int i = 0; i <= length - subsequence.GetLength(); i++) {
+            bool match = true;
+            for (int j = 0; j < subsequence.GetLength(); j++) {
+                if (data[i + j] != subsequence.Get(j)) {
+                    match = false;
+                    break;
+                }
+            }
+            if (match) return true;
+        }
+        return false;
+    }
+
+    // Изменение элемента через ссылку не перестраивает кучу
+    T& operator[](int index) override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return data[index];
+    }
+
+    const T& operator[](int index) const override {
+        if (index < 0 || index >= length)
+            throw std::out_of_range("Index out of range");
+        return data[index];
+    }
+
+    bool Contains(const T& item) const override {
+        return IndexOf(item) != -1;
+    }
+
+    int IndexOf(const T& item) const override {
+        for (int i = 0; i < length; i++) {
+            if (data[i] == item) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    bool IsEmpty() const override {
+        return length == 0;
+    }
+
+    std::string ToString() const override {
+        std::stringstream ss;
+        ss << "[";
+        for (int i = 0; i < length; i++) {
+            ss << data[i];
+            if (i < length - 1) ss << ", ";
+        }
+        ss << "]";
+        return ss.str();
+    }
+};
+
+// ==================== МЕТРИКИ ОЧЕРЕДИ ====================
+
+#if LB3_QUEUE_METRICS
+
+// Гистограмма в духе HDR: значения до 128 — точно, дальше каждая степень двойки
+// делится на 64 корзины, т.е. относительная погрешность не больше 1/64.
+// Record — только relaxed fetch_add, поэтому писать и снимать срез можно из
+// разных потоков без блокировок.
+class LatencyHistogram {
+public:
+    static constexpr int LINEAR_BUCKETS = 128;
+    static constexpr int SUB_BUCKETS = 64;
+    static constexpr int BUCKET_COUNT = LINEAR_BUCKETS + 57 * SUB_BUCKETS;
+
+private:
+    std::unique_ptr<std::atomic<std::uint64_t>[]> counts;
+    std::atomic<std::uint64_t> total{0};
+    std::atomic<std::uint64_t> sum{0};
+    std::atomic<std::uint64_t> maximum{0};
+
+    static int HighestBit(std::uint64_t value) {
+#if defined(__GNUC__)
+        return 63 - __builtin_clzll(value);
+#else
+        int bit = 0;
+        while (value >>= 1) bit++;
+        return bit;
+#endif
+    }
+
+    static int BucketOf(std::uint64_t value) {
+        if (value < LINEAR_BUCKETS) return static_cast<int>(value);
+        int shift = HighestBit(value) - 6;
+        return LINEAR_BUCKETS + (shift - 1) * SUB_BUCKETS + static_cast<int>((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Наибольшее значение, попадающее в корзину
+    static std::uint64_t UpperBoundOf(int bucket) {
+        if (bucket < LINEAR_BUCKETS) return static_cast<std::uint64_t>(bucket);
+        int shift = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 1;
+        std::uint64_t sub = static_cast<std::uint64_t>((bucket - LINEAR_BUCKETS) % SUB_BUCKETS + SUB_BUCKETS);
+        return ((sub + 1) << shift) - 1;
+    }
+
+public:
+    LatencyHistogram() : counts(std::make_unique<std::atomic<std::uint64_t>[]>(BUCKET_COUNT)) {
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            counts[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void Record(std::uint64_t value) {
+        counts[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+        std::uint64_t seen = maximum.load(std::memory_order_relaxed);
+        while (value > seen && !maximum.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    // Значение, не меньше которого quantile доли записей (верхняя граница корзины)
+    std::uint64_t Percentile(double quantile) const {
+        std::uint64_t count = total.load(std::memory_order_relaxed);
+        if (count == 0) return 0;
+        std::uint64_t rank = static_cast<std::uint64_t>(std::ceil(quantile * static_cast<double>(count)));
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (int i = 0; i < BUCKET_COUNT; i++) {
+            seen += counts[i].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(UpperBoundOf(i), GetMax());
+        }
+        return GetMax();
+    }
+
+    std::uint64_t GetCount() const { return total.load(std::memory_order_relaxed); }
+    std::uint64_t GetMax() const { return maximum.load(std::memory_order_relaxed); }
+
+    double GetMean() const {
+        std::uint64_t count = GetCount();
+        return count == 0 ? 0.0 : static_cast<double>(sum.load(std::memory_order_relaxed)) / static_cast<double>(count);
+    }
+};
+
+// Срез метрик; времена пребывания в наносекундах
+struct QueueMetricsSnapshot {
+    std::uint64_t count = 0;
+    std::uint64_t p50 = 0;
+    std::uint64_t p99 = 0;
+    std::uint64_t p999 = 0;
+    std::uint64_t max = 0;
+    double mean = 0;
+    int depth = 0;
+    int highWater = 0;
+
+    std::string ToText() const {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1)
+           << "count=" << count << " p50=" << p50 / 1000.0 << "us p99=" << p99 / 1000.0
+           << "us p999=" << p999 / 1000.0 << "us max=" << max / 1000.0 << "us mean=" << mean / 1000.0
+           << "us depth=" << depth << " high_water=" << highWater;
+        return ss.str();
+    }
+
+    std::string ToJson() const {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1)
+           << "{\"count\":" << count << ",\"p50_ns\":" << p50 << ",\"p99_ns\":" << p99 << ",\"p999_ns\":" << p999
+           << ",\"max_ns\":" << max << ",\"mean_ns\":" << mean << ",\"depth\":" << depth
+           << ",\"high_water\":" << highWater << "}";
+        return ss.str();
+    }
+};
+
+// Гистограмма времени пребывания и глубина очереди. Глубина атомарна, чтобы
+// срез можно было снимать из потока мониторинга.
+class QueueMetrics {
+private:
+    LatencyHistogram residence;
+    std::atomic<int> depth{0};
+    std::atomic<int> highWater{0};
+
+public:
+    static std::int64_t Now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void RecordResidence(std::int64_t enqueuedAt, std::int64_t now) {
+        residence.Record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, now - enqueuedAt)));
+    }
+
+    void SetDepth(int value) {
+        depth.store(value, std::memory_order_relaxed);
+        int seen = highWater.load(std::memory_order_relaxed);
+        while (value > seen && !highWater.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    void ResetHighWater() {
+        highWater.store(depth.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+
+    QueueMetricsSnapshot Snapshot() const {
+        QueueMetricsSnapshot snapshot;
+        snapshot.count = residence.GetCount();
+        snapshot.p50 = residence.Percentile(0.5);
+        snapshot.p99 = residence.Percentile(0.99);
+        snapshot.p999 = residence.Percentile(0.999);
+        snapshot.max = residence.GetMax();
+        snapshot.mean = residence.GetMean();
+        snapshot.depth = depth.load(std::memory_order_relaxed);
+        snapshot.highWater = highWater.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+};
+
+#endif
+
+// ==================== ОЧЕРЕДЬ (ЦЕЛЕВОЙ АТД) ====================
+
+// Политики хранения для Queue<T, StoragePolicy>. DynamicStorage (по умолчанию) —
+// Queue<T> с выбором хранилища во время выполнения через StorageType, остальные
+// фиксируют хранилище на этапе компиляции.
+struct DynamicStorage {};
+
+struct ArrayStorage {
+    template <typename T> using Container = ArraySequence<T>;
+    static constexpr const char* NAME = "ARRAY";
+};
+
+struct LinkedListStorage {
+    template <typename T> using Container = LinkedListSequence<T>;
+    static constexpr const char* NAME = "LINKED_LIST";
+};
+
+struct RingStorage {
+    template <typename T> using Container = RingBufferSequence<T>;
+    static constexpr const char* NAME = "RING";
+};
+
+struct DoubleEndedStorage {
+    template <typename T> using Container = DoubleEndedArraySequence<T>;
+    static constexpr const char* NAME = "DOUBLE_ENDED";
+};
+
+template <typename T, typename StoragePolicy = DynamicStorage>
+class Queue;
+
+template <typename T>
+class Queue<T, DynamicStorage> : public Sequence<T> {
 private:
     std::shared_ptr<Sequence<T>> storage;
 
+#if LB3_QUEUE_METRICS
+    // Метки времени постановки идут параллельно позициям storage. В куче (PRIORITY)
+    // позиции переставляются, поэтому там считается только глубина.
+    struct Instrumentation {
+        QueueMetrics metrics;
+        RingBufferSequence<std::int64_t> enqueueTimes;
+        bool tracksResidence = false;
+    };
+    std::unique_ptr<Instrumentation> instrumentation;
+
+    void StampAll() {
+        instrumentation->enqueueTimes.Clear();
+        if (instrumentation->tracksResidence) {
+            std::int64_t now = QueueMetrics::Now();
+            for (int i = 0; i < storage->GetLength(); i++) {
+                instrumentation->enqueueTimes.Append(now);
+            }
+        }
+        instrumentation->metrics.SetDepth(storage->GetLength());
+    }
+
+    void TrackInsert(int index, int count = 1) {
+        if (!instrumentation) return;
+        if (instrumentation->tracksResidence) {
+            std::int64_t now = QueueMetrics::Now();
+            if (count == 1) {
+                instrumentation->enqueueTimes.InsertAt(now, index);
+            } else {
+                ArraySequence<std::int64_t> stamps(count);
+                for (int i = 0; i < count; i++) {
+                    stamps.Append(now);
+                }
+                instrumentation->enqueueTimes.InsertRange(index, stamps.Data(), stamps.Data() + count);
+            }
+        }
+        instrumentation->metrics.SetDepth(storage->GetLength());
+    }
+
+    void TrackRemove(int index, bool dequeued, int count = 1) {
+        if (!instrumentation) return;
+        if (instrumentation->tracksResidence) {
+            if (dequeued) {
+                instrumentation->metrics.RecordResidence(instrumentation->enqueueTimes[index], QueueMetrics::Now());
+            }
+            instrumentation->enqueueTimes.RemoveRange(index, count);
+        }
+        instrumentation->metrics.SetDepth(storage->GetLength());
+    }
+#endif
+
+public:
+    // PRIORITY — d-арная куча: Dequeue отдаёт элемент с наивысшим приоритетом.
+    // ADAPTIVE — начинает с массива и сама переходит между ARRAY, LINKED_LIST и RING.
+    enum StorageType { ARRAY, LINKED_LIST, RING, PRIORITY, ADAPTIVE };
+
+    static const char* StorageName(StorageType type) {
+        switch (type) {
+            case ARRAY: return "ARRAY";
+            case LINKED_LIST: return "LINKED_LIST";
+            case RING: return "RING";
+            case PRIORITY: return "PRIORITY";
+            case ADAPTIVE: return "ADAPTIVE";
+        }
+        return "?";
+    }
+
+private:
+    static std::shared_ptr<Sequence<T>> MakeStorage(StorageType type) {
+        if (type == ARRAY || type == ADAPTIVE) {
+            return std::make_shared<ArraySequence<T>>();
+        } else if (type == RING) {
+            return std::make_shared<RingBufferSequence<T>>();
+        } else if (type == PRIORITY) {
+            return std::make_shared<HeapSequence<T>>();
+        }
+        return std::make_shared<LinkedListSequence<T>>();
+    }
+
+    // Режим ADAPTIVE: каждая операция добавляет свою оценочную стоимость для всех
+    // трёх представлений. Раз в ADAPTIVE_WINDOW операций хранилище переносится в
+    // самое дешёвое, если выигрыш за окно окупает перенос и превышает четверть;
+    // затем накопленное делится пополам, так что окно скользящее.
+    // Единицы условные: сдвиг элемента в массиве — MoveCost(), шаг по списку — 4,
+    // выделение узла — 3, доступ к кольцу дороже массива на 20% (перенос индекса).
+    static constexpr int ADAPTIVE_WINDOW = 256;
+
+    // Чтения идут из const-методов и могут быть параллельными, поэтому копятся
+    // в атомарных счётчиках и переносятся в cost только в Adapt() пишущим потоком
+    struct AdaptiveState {
+        StorageType current = ARRAY;
+        std::array<double, 3> cost{};
+        int operations = 0;
+        std::atomic<long long> reads{0};
+        std::atomic<long long> readSteps{0};
+        ArraySequence<std::string> log;
+        std::function<void(const std::string&)> logger;
+
+        AdaptiveState() = default;
+
+        AdaptiveState(const AdaptiveState& other)
+            : current(other.current), cost(other.cost), operations(other.operations),
+              reads(other.reads.load(std::memory_order_relaxed)),
+              readSteps(other.readSteps.load(std::memory_order_relaxed)),
+              log(other.log), logger(other.logger) {}
+    };
+    std::unique_ptr<AdaptiveState> adaptive;
+
+    static double MoveCost() {
+        return std::max(1.0, sizeof(T) / 16.0);
+    }
+
+    void AddCost(double arrayCost, double listCost, double ringCost) const {
+        adaptive->cost[ARRAY] += arrayCost;
+        adaptive->cost[LINKED_LIST] += listCost;
+        adaptive->cost[RING] += ringCost;
+        adaptive->operations++;
+    }
+
+    // Чтения считаются и в const-методах; решение о переносе — при следующем изменении
+    void CountRead(int index) const {
+        if (!adaptive) return;
+        adaptive->reads.fetch_add(1, std::memory_order_relaxed);
+        adaptive->readSteps.fetch_add(index, std::memory_order_relaxed);
+    }
+
+    // Стоимость чтения: массив — 1, список — 1 + 4 на шаг, кольцо — 1.2
+    void FoldReads() {
+        long long reads = adaptive->reads.exchange(0, std::memory_order_relaxed);
+        if (reads == 0) return;
+        long long steps = adaptive->readSteps.exchange(0, std::memory_order_relaxed);
+        adaptive->cost[ARRAY] += reads;
+        adaptive->cost[LINKED_LIST] += reads + 4.0 * steps;
+        adaptive->cost[RING] += 1.2 * reads;
+        adaptive->operations += static_cast<int>(std::min<long long>(reads, ADAPTIVE_WINDOW));
+    }
+
+    // Диапазон из count элементов сдвигает хвост один раз
+    void CountInsert(int index, int count = 1) const {
+        if (!adaptive) return;
+        int n = storage->GetLength();
+        double m = MoveCost();
+        AddCost(count + m * (n - index),
+                3.0 * count + (index == 0 || index == n ? 0 : 4.0 * index),
+                1.2 * (count + m * std::min(index, n - index)));
+    }
+
+    void CountRemove(int index, int count = 1) const {
+        if (!adaptive) return;
+        int n = storage->GetLength();
+        double m = MoveCost();
+        AddCost(count + m * (n - count - index), 3.0 * count + 4.0 * index,
+                1.2 * (count + m * std::min(index, n - count - index)));
+    }
+
+    void Adapt() {
+        if (!adaptive) return;
+        FoldReads();
+        if (adaptive->operations < ADAPTIVE_WINDOW) return;
+        adaptive->operations = 0;
+
+        StorageType current = adaptive->current;
+        StorageType best = ARRAY;
+        for (StorageType candidate : {LINKED_LIST, RING}) {
+            if (adaptive->cost[candidate] < adaptive->cost[best]) best = candidate;
+        }
+        double saving = adaptive->cost[current] - adaptive->cost[best];
+        double migration = storage->GetLength() * (MoveCost() + (best == LINKED_LIST ? 3 : 1));
+        if (best != current && saving > migration && adaptive->cost[best] < 0.75 * adaptive->cost[current]) {
+            Migrate(best);
+        }
+        for (double& cost : adaptive->cost) {
+            cost /= 2;
+        }
+    }
+
+    void Migrate(StorageType target) {
+        std::stringstream message;
+        message << StorageName(adaptive->current) << " -> " << StorageName(target)
+                << ", длина " << storage->GetLength() << ", оценка окна "
+                << static_cast<long long>(adaptive->cost[adaptive->current]) << " против "
+                << static_cast<long long>(adaptive->cost[target]);
+
+        std::shared_ptr<Sequence<T>> next = MakeStorage(target);
+        storage->ForEach([&next](const T& item) { next->Append(item); });
+        storage = next;
+        adaptive->current = target;
+
+        adaptive->log.Append(message.str());
+        if (adaptive->logger) adaptive->logger(message.str());
+    }
+
+    void CopyModeFrom(const Queue<T>& other) {
+        adaptive = other.adaptive ? std::make_unique<AdaptiveState>(*other.adaptive) : nullptr;
+    }
+
+public:
+    Queue(StorageType type = ARRAY) {
+        storage = MakeStorage(type);
+        if (type == ADAPTIVE) adaptive = std::make_unique<AdaptiveState>();
+    }
+
+    // Приоритетная очередь: before(a, b) == true — a извлекается раньше b
+    explicit Queue(typename HeapSequence<T>::Compare before) {
+        storage = std::make_shared<HeapSequence<T>>(std::move(before));
+    }
+
+    Queue(std::initializer_list<T> init, StorageType type = ARRAY) {
+        if (type == ARRAY) {
+            storage = std::make_shared<ArraySequence<T>>(init);
+        } else if (type == RING) {
+            storage = std::make_shared<RingBufferSequence<T>>(init);
+        } else if (type == PRIORITY) {
+            storage = std::make_shared<HeapSequence<T>>(init);
+        } else if (type == ADAPTIVE) {
+            storage = std::make_shared<ArraySequence<T>>(init);
+            adaptive = std::make_unique<AdaptiveState>();
+        } else {
+            storage = std::make_shared<LinkedListSequence<T>>(init);
+        }
+    }
+
+    Queue(const Queue<T>& other) {
+        storage = other.storage->GetSubsequence(0, other.GetLength() - 1);
+        CopyModeFrom(other);
+    }
+
+    Queue<T>& operator=(const Queue<T>& other) {
+        if (this != &other) {
+            storage = other.storage->GetSubsequence(0, other.GetLength() - 1);
+            CopyModeFrom(other);
+#if LB3_QUEUE_METRICS
+            if (instrumentation) StampAll();
+#endif
+        }
+        return *this;
+    }
+
+    // Основные методы очереди
+    void Enqueue(const T& item) {
+        Adapt();
+        CountInsert(storage->GetLength());
+        storage->Append(item);
+#if LB3_QUEUE_METRICS
+        TrackInsert(storage->GetLength() - 1);
+#endif
+    }
+
+    T Dequeue() {
+        if (storage->IsEmpty()) throw std::out_of_range("Queue is empty");
+        Adapt();
+        CountRemove(0);
+        T item = storage->GetFirst();
+        storage->RemoveAt(0);
+#if LB3_QUEUE_METRICS
+        TrackRemove(0, true);
+#endif
+        return item;
+    }
+
+    T Peek() const {
+        if (storage->IsEmpty()) throw std::out_of_range("Queue is empty");
+        return storage->GetFirst();
+    }
+
+    // Реализация методов Sequence
+    T GetFirst() const override { return storage->GetFirst(); }
+    T GetLast() const override { return storage->GetLast(); }
+    T Get(int index) const override {
+        CountRead(index);
+        return storage->Get(index);
+    }
+
+    std::shared_ptr<Sequence<T>> GetSubsequence(int startIndex, int endIndex) const override {
+        return storage->GetSubsequence(startIndex, endIndex);
+    }
+    int GetLength() const override { return storage->GetLength(); }
+
+    void Append(const T& item) override { Enqueue(item); }
+
+    void Prepend(const T& item) override {
+        Adapt();
+        CountInsert(0);
+        storage->Prepend(item);
+#if LB3_QUEUE_METRICS
+        TrackInsert(0);
+#endif
+    }
+
+    void InsertAt(const T& item, int index) override {
+        Adapt();
+        if (index >= 0 && index <= storage->GetLength()) CountInsert(index);
+        storage->InsertAt(item, index);
+#if LB3_QUEUE_METRICS
+        TrackInsert(index);
+#endif
+    }
+
+    void RemoveAt(int index) override {
+        Adapt();
+        if (index >= 0 && index < storage->GetLength()) CountRemove(index);
+        storage->RemoveAt(index);
+#if LB3_QUEUE_METRICS
+        TrackRemove(index, false);
+#endif
+    }
+
+    void InsertRange(int index, const T* first, const T* last) override {
+        Adapt();
+        int count = static_cast<int>(last - first);
+        if (index >= 0 && index <= storage->GetLength()) CountInsert(index, count);
+        storage->InsertRange(index, first, last);
+#if LB3_QUEUE_METRICS
+        if (count > 0) TrackInsert(index, count);
+#endif
+    }
+
+    void RemoveRange(int start, int count) override {
+        Adapt();
+        if (start >= 0 && count >= 0 && start + count <= storage->GetLength()) CountRemove(start, count);
+        storage->RemoveRange(start, count);
+#if LB3_QUEUE_METRICS
+        if (count > 0) TrackRemove(start, false, count);
+#endif
+    }
+
+    void Remove(const T& item) override {
+        int index = storage->IndexOf(item);
+        if (index != -1) {
+            RemoveAt(index);
+        }
+    }
+
+    void Clear() override {
+        storage->Clear();
+#if LB3_QUEUE_METRICS
+        if (instrumentation) StampAll();
+#endif
+    }
+
+    std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const override {
+        return storage->Concat(other);
+    }
+
+    std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const override {
+        return storage->Map(func);
+    }
+
+    std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const override {
+        return storage->Where(predicate);
+    }
+
+    T Reduce(std::function<T(T, T)> func, T initial) const override {
+        return storage->Reduce(func, initial);
+    }
+
+    void ForEach(const std::function<void(const T&)>& visit) const override {
+        storage->ForEach(visit);
+    }
+
+    std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
+        return storage->Zip(other);
+    }
+
+    std::pair<std::shared_ptr<Sequence<T>>, std::shared_ptr<Sequence<T>>> Split(std::function<bool(T)> predicate) const override {
+        return storage->Split(predicate);
+    }
+
+    std::shared_ptr<Sequence<T>> Slice(int start, int end) const override {
+        return storage->Slice(start, end);
+    }
+
+    bool ContainsSubsequence(const Sequence<T>& subsequence) const override {
+        return storage->ContainsSubsequence(subsequence);
+    }
+
+    // Без Adapt(): перенос заменил бы storage, и выданные ранее ссылки повисли бы
+    T& operator[](int index) override {
+        CountRead(index);
+        return (*storage)[index];
+    }
+
+    const T& operator[](int index) const override {
+        CountRead(index);
+        return (*storage)[index];
+    }
+
+    bool Contains(const T& item) const override { return storage->Contains(item); }
+    int IndexOf(const T& item) const override { return storage->IndexOf(item); }
+    bool IsEmpty() const override { return storage->IsEmpty(); }
+
+    std::string ToString() const override {
+        return storage->ToString();
+    }
+
+    bool IsAdaptive() const {
+        return adaptive != nullptr;
+    }
+
+    // Для ADAPTIVE — текущее представление
+    StorageType GetStorageType() const {
+        if (adaptive) return adaptive->current;
+        if (dynamic_cast<ArraySequence<T>*>(storage.get())) return ARRAY;
+        if (dynamic_cast<RingBufferSequence<T>*>(storage.get())) return RING;
+        if (dynamic_cast<HeapSequence<T>*>(storage.get())) return PRIORITY;
+        return LINKED_LIST;
+    }
+
+    // Переносы хранилища в режиме ADAPTIVE, по одной строке на перенос
+    const ArraySequence<std::string>& GetMigrationLog() const {
+        if (!adaptive) throw std::logic_error("Queue is not adaptive");
+        return adaptive->log;
+    }
+
+    void SetMigrationLogger(std::function<void(const std::string&)> logger) {
+        if (!adaptive) throw std::logic_error("Queue is not adaptive");
+        adaptive->logger = std::move(logger);
+    }
+
+#if LB3_QUEUE_METRICS
+    // Уже лежащие элементы считаются поставленными в момент включения
+    void EnableMetrics() {
+        if (instrumentation) return;
+        instrumentation = std::make_unique<Instrumentation>();
+        instrumentation->tracksResidence = !dynamic_cast<HeapSequence<T>*>(storage.get());
+        StampAll();
+    }
+
+    void DisableMetrics() {
+        instrumentation.reset();
+    }
+
+    bool HasMetrics() const {
+        return instrumentation != nullptr;
+    }
+
+    QueueMetricsSnapshot GetMetrics() const {
+        if (!instrumentation) throw std::logic_error("Metrics are not enabled");
+        return instrumentation->metrics.Snapshot();
+    }
+
+    void ResetHighWater() {
+        if (instrumentation) instrumentation->metrics.ResetHighWater();
+    }
+#endif
+
+    // Специфичные методы для очереди
+    std::shared_ptr<Queue<T>> Filter(std::function<bool(T)> predicate) const {
+        auto result = std::make_shared<Queue<T>>();
+        for (int i = 0; i < GetLength(); i++) {
+            T item = Get(i);
+            if (predicate(item)) {
+                result->Enqueue(item);
+            }
+        }
+        return result;
+    }
+
+    void Serialize(const std::string& filename) const {
+        std::ofstream file(filename);
+        for (int i = 0; i < GetLength(); i++) {
+            file << Get(i) << "\n";
+        }
+    }
+
+    void Deserialize(const std::string& filename) {
+        std::ifstream file(filename);
+        T item;
+        while (file >> item) {
+            Enqueue(item);
+        }
+    }
+
+    // Двоичный снимок (см. SnapshotHeader): строки с пробелами и Person сохраняются без потерь
+    void SerializeBinary(const std::string& filename) const {
+        WriteBinarySnapshot(filename, *storage);
+    }
+
+#if defined(__linux__)
+    // В отличие от Deserialize, заменяет текущее содержимое
+    void DeserializeBinary(const std::string& filename) {
+        SnapshotView<T> view(filename);
+        Clear();
+        for (int i = 0; i < view.GetLength(); i++) {
+            Enqueue(T(view.Get(i)));
+        }
+    }
+#endif
+};
+
+// ==================== ОЧЕРЕДЬ СО СТАТИЧЕСКОЙ ДИСПЕТЧЕРИЗАЦИЕЙ ====================
+
+// Тот же интерфейс, что у Queue<T>, но хранилище — поле конкретного типа, а не
+// shared_ptr<Sequence<T>>: вызовы идут напрямую и встраиваются компилятором.
+// Сама очередь не наследует Sequence<T>; функциональные методы возвращают
+// последовательности того же вида, что и у Queue<T>.
+template <typename T, typename StoragePolicy>
+class Queue {
+private:
+    typename StoragePolicy::template Container<T> storage;
+
+public:
+    Queue() = default;
+
+    Queue(std::initializer_list<T> init) : storage(init) {}
+
+    static const char* StorageName() { return StoragePolicy::NAME; }
+
+    // Основные методы очереди
+    void Enqueue(const T& item) {
+        storage.Append(item);
+    }
+
+    T Dequeue() {
+        if (storage.IsEmpty()) throw std::out_of_range("Queue is empty");
+        T item = storage.GetFirst();
+        storage.RemoveAt(0);
+        return item;
+    }
+
+    T Peek() const {
+        if (storage.IsEmpty()) throw std::out_of_range("Queue is empty");
+        return storage.GetFirst();
+    }
+
+    T GetFirst() const { return storage.GetFirst(); }
+    T GetLast() const { return storage.GetLast(); }
+    T Get(int index) const { return storage.Get(index); }
+    std::shared_ptr<Sequence<T>> GetSubsequence(int startIndex, int endIndex) const {
+        return storage.GetSubsequence(startIndex, endIndex);
+    }
+    int GetLength() const { return storage.GetLength(); }
+
+    void Append(const T& item) { Enqueue(item); }
+    void Prepend(const T& item) { storage.Prepend(item); }
+    void InsertAt(const T& item, int index) { storage.InsertAt(item, index); }
+    void RemoveAt(int index) { storage.RemoveAt(index); }
+    void Remove(const T& item) { storage.Remove(item); }
+    void Clear() { storage.Clear(); }
+    void AppendRange(const T* first, const T* last) { storage.AppendRange(first, last); }
+    void InsertRange(int index, const T* first, const T* last) { storage.InsertRange(index, first, last); }
+    void RemoveRange(int start, int count) { storage.RemoveRange(start, count); }
+
+    std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const { return storage.Concat(other); }
+    std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const { return storage.Map(func); }
+    std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const { return storage.Where(predicate); }
+    T Reduce(std::function<T(T, T)> func, T initial) const { return storage.Reduce(func, initial); }
+    void ForEach(const std::function<void(const T&)>& visit) const { storage.ForEach(visit); }
+    std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const { return storage.Zip(other); }
+
+    std::pair<std::shared_ptr<Sequence<T>>, std::shared_ptr<Sequence<T>>> Split(std::function<bool(T)> predicate) const {
+        return storage.Split(predicate);
+    }
+
+    std::shared_ptr<Sequence<T>> Slice(int start, int end) const { return storage.Slice(start, end); }
+    bool ContainsSubsequence(const Sequence<T>& subsequence) const { return storage.ContainsSubsequence(subsequence); }
+
+    T& operator[](int index) { return storage[index]; }
+    const T& operator[](int index) const { return storage[index]; }
+
+    bool Contains(const T& item) const { return storage.Contains(item); }
+    int IndexOf(const T& item) const { return storage.IndexOf(item); }
+    bool IsEmpty() const { return storage.IsEmpty(); }
+    std::string ToString() const { return storage.ToString(); }
+
+    // Хранилище как Sequence<T> — для кода, которому нужен полиморфный интерфейс
+    const Sequence<T>& AsSequence() const { return storage; }
+
+    std::shared_ptr<Queue<T, StoragePolicy>> Filter(std::function<bool(T)> predicate) const {
+        auto result = std::make_shared<Queue<T, StoragePolicy>>();
+        for (int i = 0; i < GetLength(); i++) {
+            T item = Get(i);
+            if (predicate(item)) {
+                result->Enqueue(item);
+            }
+        }
+        return result;
+    }
+
+    void Serialize(const std::string& filename) const {
+        std::ofstream file(filename);
+        for (int i = 0; i < GetLength(); i++) {
+            file << Get(i) << "\n";
+        }
+    }
+
+    void Deserialize(const std::string& filename) {
+        std::ifstream file(filename);
+        T item;
+        while (file >> item) {
+            Enqueue(item);
+        }
+    }
+
+    void SerializeBinary(const std::string& filename) const {
+        WriteBinarySnapshot(filename, storage);
+    }
+
+#if defined(__linux__)
+    void DeserializeBinary(const std::string& filename) {
+        SnapshotView<T> view(filename);
+        Clear();
+        for (int i = 0; i < view.GetLength(); i++) {
+            Enqueue(T(view.Get(i)));
+        }
+    }
+#endif
+};
+
+// ==================== ПАРНАЯ КУЧА ====================
+
+// Очередь с приоритетом, где уже поставленный элемент можно поднять по дескриптору
+// (перенос дедлайна на более ранний) за O(1) амортизированно. Enqueue — O(1),
+// Dequeue — O(log N) амортизированно (двухпроходное слияние поддеревьев).
+// Узлы берутся из блоков и переиспользуются, дескриптор — адрес узла; он
+// действителен, пока его элемент не извлечён.
+template <typename T>
+class PairingHeap {
+public:
+    using Compare = std::function<bool(const T&, const T&)>;
+
+private:
+    struct Node {
+        T value;
+        Node* child = nullptr;
+        Node* sibling = nullptr;
+        // Левый брат либо родитель для первого потомка; nullptr у корня
+        Node* prev = nullptr;
+    };
+
+    static constexpr int NODES_PER_BLOCK = 256;
+
+    std::vector<std::unique_ptr<Node[]>> blocks;
+    Node* freeList = nullptr;
+    Node* root = nullptr;
+    int length = 0;
+    Compare before;
+
+    Node* Allocate(const T& value) {
+        if (!freeList) {
+            blocks.push_back(std::make_unique<Node[]>(NODES_PER_BLOCK));
+            Node* block = blocks.back().get();
+            for (int i = 0; i < NODES_PER_BLOCK; i++) {
+                block[i].sibling = freeList;
+                freeList = &block[i];
+            }
+        }
+        Node* node = freeList;
+        freeList = node->sibling;
+        node->value = value;
+        node->child = node->sibling = node->prev = nullptr;
+        return node;
+    }
+
+    void Release(Node* node) {
+        node->value = T();
+        node->child = node->prev = nullptr;
+        node->sibling = freeList;
+        freeList = node;
+    }
+
+    // Подвешивает корень с меньшим приоритетом первым потомком другого
+    Node* Meld(Node* a, Node* b) {
+        if (!a) return b;
+        if (!b) return a;
+        if (before(b->value, a->value)) std::swap(a, b);
+        b->prev = a;
+        b->sibling = a->child;
+        if (a->child) a->child->prev = b;
+        a->child = b;
+        a->sibling = nullptr;
+        return a;
+    }
+
+    // Слияние потомков парами слева направо, затем справа налево — без рекурсии
+    Node* MergePairs(Node* first) {
+        if (!first) return nullptr;
+        Node* paired = nullptr;
+        while (first) {
+            Node* a = first;
+            Node* b = a->sibling;
+            first = b ? b->sibling : nullptr;
+            a->sibling = a->prev = nullptr;
+            if (b) b->sibling = b->prev = nullptr;
+            Node* merged = Meld(a, b);
+            merged->sibling = paired;
+            paired = merged;
+        }
+        Node* result = nullptr;
+        while (paired) {
+            Node* next = paired->sibling;
+            paired->sibling = nullptr;
+            result = Meld(result, paired);
+            paired = next;
+        }
+        return result;
+    }
+
+    void Detach(Node* node) {
+        if (node->prev->child == node) {
+            node->prev->child = node->sibling;
+        } else {
+            node->prev->sibling = node->sibling;
+        }
+        if (node->sibling) node->sibling->prev = node->prev;
+        node->sibling = node->prev = nullptr;
+    }
+
+public:
+    class Handle {
+    private:
+        Node* node = nullptr;
+        explicit Handle(Node* node) : node(node) {}
+        friend class PairingHeap<T>;
+
+    public:
+        Handle() = default;
+        bool operator==(const Handle& other) const { return node == other.node; }
+    };
+
+    explicit PairingHeap(Compare before = DefaultBefore<T>) : before(std::move(before)) {}
+
+    PairingHeap(const PairingHeap<T>&) = delete;
+    PairingHeap<T>& operator=(const PairingHeap<T>&) = delete;
+
+    Handle Enqueue(const T& item) {
+        Node* node = Allocate(item);
+        root = Meld(root, node);
+        length++;
+        return Handle(node);
+    }
+
+    T Dequeue() {
+        if (!root) throw std::out_of_range("Queue is empty");
+        Node* top = root;
+        T item = std::move(top->value);
+        root = MergePairs(top->child);
+        Release(top);
+        length--;
+        return item;
+    }
+
+    const T& Peek() const {
+        if (!root) throw std::out_of_range("Queue is empty");
+        return root->value;
+    }
+
+    const T& Get(Handle handle) const {
+        return handle.node->value;
+    }
+
+    // Новое значение не должно извлекаться позже текущего
+    void DecreaseKey(Handle handle, const T& value) {
+        Node* node = handle.node;
+        if (before(node->value, value)) {
+            throw std::invalid_argument("DecreaseKey cannot lower the priority");
+        }
+        node->value = value;
+        if (node == root) return;
+        Detach(node);
+        root = Meld(root, node);
+    }
+
+    int GetLength() const { return length; }
+    bool IsEmpty() const { return length == 0; }
+
+    void Clear() {
+        blocks.clear();
+        freeList = nullptr;
+        root = nullptr;
+        length = 0;
+    }
+};
+
+// ==================== ОЧЕРЕДЬ С ЗАДЕРЖКОЙ ====================
+
+// Элементы становятся видны Dequeue только по истечении задержки. Таймеры лежат
+// в иерархическом колесе: LEVELS уровней по SLOTS ячеек, ячейка уровня L покрывает
+// SLOTS^L тиков. Вставка и отмена — O(1) (двусвязные списки ячеек), при переходе
+// через границу уровня его ячейка раскладывается по нижним уровням. Истёкшие
+// элементы переносятся в обычную Queue<T>. Не потокобезопасна, как и Queue.
+template <typename T>
+class DelayedQueue {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int LEVELS = 4;
+    static constexpr int SLOT_BITS = 6;
+    static constexpr int SLOTS = 1 << SLOT_BITS;
+
+private:
+    struct Timer {
+        T item;
+        std::uint64_t expiry = 0;
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+        int slot = -1;
+        std::uint32_t generation = 0;
+    };
+
+    static constexpr int TIMERS_PER_BLOCK = 256;
+    static constexpr std::uint64_t MAX_DELTA = (std::uint64_t(1) << (SLOT_BITS * LEVELS)) - 1;
+
+    std::vector<std::unique_ptr<Timer[]>> blocks;
+    Timer* freeList = nullptr;
+    std::array<Timer*, LEVELS * SLOTS> slots{};
+    Queue<T> ready;
+
+    Clock::time_point origin;
+    std::chrono::nanoseconds tick;
+    std::uint64_t currentTick = 0;
+    int pending = 0;
+
+    Timer* Allocate() {
+        if (!freeList) {
+            blocks.push_back(std::make_unique<Timer[]>(TIMERS_PER_BLOCK));
+            Timer* block = blocks.back().get();
+            for (int i = 0; i < TIMERS_PER_BLOCK; i++) {
+                block[i].next = freeList;
+                freeList = &block[i];
+            }
+        }
+        Timer* timer = freeList;
+        freeList = timer->next;
+        return timer;
+    }
+
+    // Поколение меняется, поэтому старые дескрипторы узла перестают действовать
+    void Release(Timer* timer) {
+        timer->item = T();
+        timer->slot = -1;
+        timer->generation++;
+        timer->prev = nullptr;
+        timer->next = freeList;
+        freeList = timer;
+    }
+
+    void Link(Timer* timer) {
+        std::uint64_t delta = timer->expiry - currentTick;
+        if (timer->expiry <= currentTick) {
+            ready.Enqueue(std::move(timer->item));
+            Release(timer);
+            pending--;
+            return;
+        }
+        // Дальше горизонта колеса — в верхний уровень; при раскладке вставится заново
+        delta = std::min(delta, MAX_DELTA);
+        std::uint64_t at = currentTick + delta;
+        int level = 0;
+        while (delta >= (std::uint64_t(1) << (SLOT_BITS * (level + 1)))) level++;
+        int slot = level * SLOTS + static_cast<int>((at >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+        timer->slot = slot;
+        timer->prev = nullptr;
+        timer->next = slots[slot];
+        if (timer->next) timer->next->prev = timer;
+        slots[slot] = timer;
+    }
+
+    void Unlink(Timer* timer) {
+        if (timer->prev) {
+            timer->prev->next = timer->next;
+        } else {
+            slots[timer->slot] = timer->next;
+        }
+        if (timer->next) timer->next->prev = timer->prev;
+    }
+
+    // Снимает всю ячейку и вставляет её таймеры заново относительно currentTick
+    void Cascade(int slot) {
+        Timer* timer = slots[slot];
+        slots[slot] = nullptr;
+        while (timer) {
+            Timer* next = timer->next;
+            Link(timer);
+            timer = next;
+        }
+    }
+
+    void Step() {
+        currentTick++;
+        for (int level = LEVELS - 1; level >= 1; level--) {
+            if ((currentTick & ((std::uint64_t(1) << (SLOT_BITS * level)) - 1)) == 0) {
+                Cascade(level * SLOTS + static_cast<int>((currentTick >> (SLOT_BITS * level)) & (SLOTS - 1)));
+            }
+        }
+        Cascade(static_cast<int>(currentTick & (SLOTS - 1)));
+    }
+
+    std::uint64_t TickOf(Clock::time_point time) const {
+        if (time <= origin) return 0;
+        return static_cast<std::uint64_t>((time - origin + tick - std::chrono::nanoseconds(1)) / tick);
+    }
+
+public:
+    class Handle {
+    private:
+        Timer* timer = nullptr;
+        std::uint32_t generation = 0;
+        Handle(Timer* timer, std::uint32_t generation) : timer(timer), generation(generation) {}
+        friend class DelayedQueue<T>;
+
+    public:
+        Handle() = default;
+    };
+
+    explicit DelayedQueue(std::chrono::nanoseconds tick = std::chrono::milliseconds(1),
+                          Clock::time_point origin = Clock::now())
+        : ready(Queue<T>::RING), origin(origin), tick(tick) {
+        if (tick.count() <= 0) throw std::invalid_argument("Tick must be positive");
+    }
+
+    DelayedQueue(const DelayedQueue<T>&) = delete;
+    DelayedQueue<T>& operator=(const DelayedQueue<T>&) = delete;
+
+    // Срок округляется вверх до тика: элемент не появится раньше времени
+    Handle EnqueueAt(const T& item, Clock::time_point due) {
+        Timer* timer = Allocate();
+        timer->item = item;
+        timer->expiry = TickOf(due);
+        pending++;
+        std::uint32_t generation = timer->generation;
+        Link(timer);
+        return Handle(timer, generation);
+    }
+
+    Handle EnqueueAfter(const T& item, std::chrono::nanoseconds delay) {
+        return EnqueueAt(item, Clock::now() + delay);
+    }
+
+    void Enqueue(const T& item) {
+        ready.Enqueue(item);
+    }
+
+    // false — элемент уже истёк или отменён
+    bool Cancel(Handle handle) {
+        Timer* timer = handle.timer;
+        if (!timer || timer->generation != handle.generation || timer->slot < 0) return false;
+        Unlink(timer);
+        Release(timer);
+        pending--;
+        return true;
+    }
+
+    // Переводит колесо ко времени now; возвращает число истёкших за шаг элементов.
+    // Время не идёт назад: более раннее now ничего не делает.
+    int Advance(Clock::time_point now) {
+        std::uint64_t target = TickOf(now);
+        int before = ready.GetLength();
+        if (pending == 0 && target > currentTick) {
+            currentTick = target;
+        }
+        while (currentTick < target && pending > 0) {
+            Step();
+        }
+        currentTick = std::max(currentTick, target);
+        return ready.GetLength() - before;
+    }
+
+    bool TryDequeue(T& out) {
+        Advance(Clock::now());
+        if (ready.IsEmpty()) return false;
+        out = ready.Dequeue();
+        return true;
+    }
+
+    T Dequeue() {
+        Advance(Clock::now());
+        return ready.Dequeue();
+    }
+
+    // Истёкшие элементы, ещё не забранные Dequeue
+    int GetLength() const { return ready.GetLength(); }
+    int GetPendingCount() const { return pending; }
+    bool IsEmpty() const { return ready.IsEmpty(); }
+};
+
+// ==================== СКОЛЬЗЯЩЕЕ ОКНО С АГРЕГАТОМ ====================
+
+// Очередь, поддерживающая свёртку combine всех своих элементов (от старых к новым)
+// за амортизированное O(1) на Enqueue/Dequeue — «две стопки»: задняя часть окна
+// хранит одну накопленную свёртку, передняя — свёртки суффиксов, пересчитываемые
+// разом, когда передняя часть опустела. combine должна быть ассоциативной, identity —
+// её нейтральный элемент; коммутативность не требуется.
+// Если задана обратная операция (inverse(total, x) убирает x из начала свёртки,
+// например вычитание для суммы), хранится только общий итог. Для double итог
+// копит погрешность округления.
+// windowSize > 0 — Enqueue сам вытесняет старейший элемент при заполнении окна.
+template <typename T>
+class SlidingWindowQueue {
+public:
+    using Combine = std::function<T(const T&, const T&)>;
+
+private:
+    Queue<T> items;
+    Combine combine;
+    Combine inverse;
+    T identity;
+    int windowSize;
+
+    // Свёртки суффиксов передней части: последний элемент соответствует старейшему
+    ArraySequence<T> frontAggregates;
+    T backAggregate;
+    T total;
+
+    // Переносит всю заднюю часть в переднюю: один проход с конца
+    void Flip() {
+        T suffix = identity;
+        for (int i = items.GetLength() - 1; i >= 0; i--) {
+            suffix = combine(items[i], suffix);
+            frontAggregates.Append(suffix);
+        }
+        backAggregate = identity;
+    }
+
+public:
+    SlidingWindowQueue(Combine combine, T identity, int windowSize = 0, Combine inverse = nullptr)
+        : items(Queue<T>::RING), combine(std::move(combine)), inverse(std::move(inverse)),
+          identity(identity), windowSize(windowSize), backAggregate(identity), total(identity) {
+        if (windowSize < 0) throw std::invalid_argument("Window size must be non-negative");
+    }
+
+    void Enqueue(const T& item) {
+        if (windowSize > 0 && items.GetLength() == windowSize) {
+            Dequeue();
+        }
+        items.Enqueue(item);
+        if (inverse) {
+            total = combine(total, item);
+        } else {
+            backAggregate = combine(backAggregate, item);
+        }
+    }
+
+    T Dequeue() {
+        T item = items.Dequeue();
+        if (inverse) {
+            total = items.IsEmpty() ? identity : inverse(total, item);
+            return item;
+        }
+        if (frontAggregates.IsEmpty()) {
+            // items уже без item: свёртки строятся по оставшимся, item покидает окно
+            Flip();
+            return item;
+        }
+        frontAggregates.RemoveAt(frontAggregates.GetLength() - 1);
+        return item;
+    }
+
+    T Peek() const {
+        return items.Peek();
+    }
+
+    // Свёртка всех элементов окна; identity для пустого
+    T GetAggregate() const {
+        if (inverse) return total;
+        if (frontAggregates.IsEmpty()) return backAggregate;
+        return combine(frontAggregates.GetLast(), backAggregate);
+    }
+
+    void Clear() {
+        items.Clear();
+        frontAggregates.Clear();
+        backAggregate = identity;
+        total = identity;
+    }
+
+    int GetLength() const { return items.GetLength(); }
+    bool IsEmpty() const { return items.IsEmpty(); }
+    int GetWindowSize() const { return windowSize; }
+    bool IsInvertible() const { return static_cast<bool>(inverse); }
+};
+
+// ==================== ОЧЕРЕДЬ С ВЫГРУЗКОЙ НА ДИСК ====================
+
+// FIFO-очередь с ограничением памяти. Элементы лежат сегментами по segmentItems;
+// голова (из неё читают) и хвост (в него пишут) всегда в памяти. Когда оценка
+// занятой памяти превышает бюджет, средние сегменты записываются во временные
+// файлы (BinaryCodec) и освобождаются. Выгруженные сегменты идут одним блоком:
+// сначала он растёт к хвосту, затем от своего начала к голове. Сегмент за головой
+// читается с диска в фоне (std::async), когда голова прочитана наполовину;
+// Dequeue ждёт диск, только если чтение не успело. Каждый элемент пишется и
+// читается с диска не больше одного раза, поэтому Enqueue и Dequeue остаются
+// O(1) амортизированно. Бюджет стоит давать хотя бы на 3-4 сегмента.
+template <typename T>
+class SpillQueue {
+private:
+    struct Segment {
+        RingBufferSequence<T> items;
+        std::size_t bytes = 0;
+        int count = 0;
+        std::string file;
+        std::future<RingBufferSequence<T>> loading;
+
+        bool IsSpilled() const { return !file.empty(); }
+    };
+
+    RingBufferSequence<std::shared_ptr<Segment>> segments;
+    std::size_t memoryBudget;
+    int segmentItems;
+    std::filesystem::path directory;
+    std::string filePrefix;
+    std::size_t memoryBytes = 0;
+    int length = 0;
+    int spilledBegin = 0;      // выгруженный блок — segments[spilledBegin, spilledBegin + spilledSegments)
+    int spilledSegments = 0;
+    long long fileCounter = 0;
+    long long spillCount = 0;
+    std::string scratch;
+
+    // Оценка памяти элемента: сам объект плюс данные в куче
+    std::size_t Footprint(const T& item) {
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            return sizeof(T);
+        } else if constexpr (std::is_same_v<T, std::string>) {
+            return sizeof(T) + item.capacity();
+        } else {
+            scratch.clear();
+            BinaryCodec<T>::Write(scratch, item);
+            return sizeof(T) + scratch.size();
+        }
+    }
+
+    void Spill(Segment& segment) {
+        std::string buffer;
+        BinaryCodec<std::uint32_t>::Write(buffer, static_cast<std::uint32_t>(segment.count));
+        for (int i = 0; i < segment.items.GetLength(); i++) {
+            BinaryCodec<T>::Write(buffer, segment.items[i]);
+        }
+
+        std::string file = (directory / (filePrefix + std::to_string(fileCounter++) + ".spill")).string();
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!out) throw std::runtime_error("Cannot write spill file " + file);
+
+        segment.file = file;
+        segment.items = RingBufferSequence<T>();
+        memoryBytes -= segment.bytes;
+        spilledSegments++;
+        spillCount++;
+    }
+
+    // Читает файл сегмента; выполняется в фоновом потоке и не трогает очередь
+    static RingBufferSequence<T> ReadSpillFile(const std::string& file, int expectedCount) {
+        std::ifstream in(file, std::ios::binary);
+        std::string buffer((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        const char* cursor = buffer.data();
+        const char* end = cursor + buffer.size();
+        std::uint32_t count = 0;
+        if (!BinaryCodec<std::uint32_t>::Read(cursor, end, count) || static_cast<int>(count) != expectedCount) {
+            throw std::runtime_error("Corrupted spill file " + file);
+        }
+
+        RingBufferSequence<T> items(expectedCount);
+        for (int i = 0; i < expectedCount; i++) {
+            T item;
+            if (!BinaryCodec<T>::Read(cursor, end, item)) throw std::runtime_error("Corrupted spill file " + file);
+            items.Append(item);
+        }
+        return items;
+    }
+
+    // Снимает первый сегмент выгруженного блока и начинает читать его в фоне
+    void StartLoad(Segment& segment) {
+        segment.loading = std::async(std::launch::async, &SpillQueue<T>::ReadSpillFile, segment.file, segment.count);
+        memoryBytes += segment.bytes;
+        spilledBegin++;
+        spilledSegments--;
+        EnforceBudget();
+    }
+
+    // Дожидается чтения головы, если оно ещё идёт
+    void EnsureLoaded(Segment& segment) {
+        if (!segment.IsSpilled()) return;
+        if (!segment.loading.valid()) StartLoad(segment);
+        segment.items = segment.loading.get();
+        std::remove(segment.file.c_str());
+        segment.file.clear();
+    }
+
+    // Наращивает блок к хвосту, затем вниз от его начала; уже выгруженные сегменты не просматриваются
+    void EnforceBudget() {
+        int top = segments.GetLength() - 2;
+        if (spilledSegments == 0) spilledBegin = top + 1;
+        for (int i = spilledBegin + spilledSegments; i <= top && memoryBytes > memoryBudget; i++) {
+            Spill(*segments[i]);
+        }
+        while (spilledBegin > 2 && memoryBytes > memoryBudget) {
+            spilledBegin--;
+            Spill(*segments[spilledBegin]);
+        }
+    }
+
+    // Фоновая подкачка сегмента за головой, пока голова ещё не кончилась
+    void Prefetch() {
+        if (spilledSegments > 0 && spilledBegin == 1 && segments[0]->items.GetLength() <= segmentItems / 2) {
+            StartLoad(*segments[1]);
+        }
+    }
+
+public:
+    explicit SpillQueue(std::size_t memoryBudget, int segmentItems = 4096,
+                        const std::filesystem::path& directory = std::filesystem::temp_directory_path())
+        : memoryBudget(memoryBudget), segmentItems(std::max(1, segmentItems)), directory(directory) {
+        filePrefix = "lb3_spill_" + std::to_string(reinterpret_cast<std::uintptr_t>(this)) + "_" +
+                     std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()) + "_";
+    }
+
+    SpillQueue(const SpillQueue<T>&) = delete;
+    SpillQueue<T>& operator=(const SpillQueue<T>&) = delete;
+
+    ~SpillQueue() {
+        for (int i = 0; i < segments.GetLength(); i++) {
+            Segment& segment = *segments[i];
+            if (segment.loading.valid()) segment.loading.wait();
+            if (segment.IsSpilled()) std::remove(segment.file.c_str());
+        }
+    }
+
+    void Enqueue(const T& item) {
+        if (segments.IsEmpty() || segments.GetLast()->count == segmentItems) {
+            segments.Append(std::make_shared<Segment>());
+        }
+        Segment& tail = *segments.GetLast();
+        std::size_t bytes = Footprint(item);
+        tail.items.Append(item);
+        tail.bytes += bytes;
+        tail.count++;
+        memoryBytes += bytes;
+        length++;
+        if (memoryBytes > memoryBudget) EnforceBudget();
+    }
+
+    T Dequeue() {
+        if (length == 0) throw std::out_of_range("Queue is empty");
+        Segment& head = *segments.GetFirst();
+        EnsureLoaded(head);
+
+        T item = head.items.GetFirst();
+        head.items.RemoveAt(0);
+        // Оценка копии может отличаться от оценки при записи; остаток сегмента
+        // списывается целиком, когда он опустеет
+        std::size_t bytes = std::min(Footprint(item), head.bytes);
+        head.bytes -= bytes;
+        memoryBytes -= bytes;
+        length--;
+
+        if (head.items.IsEmpty() && (segments.GetLength() > 1 || head.count == segmentItems)) {
+            memoryBytes -= head.bytes;
+            segments.RemoveAt(0);
+            if (spilledSegments > 0) spilledBegin--;
+        }
+        Prefetch();
+        return item;
+    }
+
+    T Peek() {
+        if (length == 0) throw std::out_of_range("Queue is empty");
+        Segment& head = *segments.GetFirst();
+        EnsureLoaded(head);
+        return head.items.GetFirst();
+    }
+
+    int GetLength() const { return length; }
+    bool IsEmpty() const { return length == 0; }
+    std::size_t GetMemoryBytes() const { return memoryBytes; }
+    std::size_t GetMemoryBudget() const { return memoryBudget; }
+    int GetSpilledSegmentCount() const { return spilledSegments; }
+    long long GetSpillCount() const { return spillCount; }
+};
+
+// ==================== ОЧЕРЕДЬ SPSC (БЕЗ БЛОКИРОВОК) ====================
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+// Очередь фиксированной ёмкости для одного производителя и одного потребителя.
+// Производитель пишет только tail, потребитель — только head; каждый держит
+// локальную копию чужого индекса и перечитывает атомик, лишь когда буфер
+// выглядит полным (пустым). Индексы растут монотонно, слот = индекс & mask.
+template <typename T>
+class SpscQueue {
+private:
+    std::unique_ptr<T[]> slots;
+    std::size_t capacity;
+    std::size_t mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head{0};
+    std::size_t cachedTail = 0;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail{0};
+    std::size_t cachedHead = 0;
+
+    static std::size_t RoundUpToPowerOfTwo(std::size_t value) {
+        std::size_t result = 1;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    template <typename U>
+    bool TryEnqueueImpl(U&& item) {
+        std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == capacity) return false;
+        }
+        slots[t & mask] = std::forward<U>(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool HasItem(std::size_t h) {
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) return false;
+        }
+        return true;
+    }
+
+public:
+    explicit SpscQueue(int requestedCapacity) {
+        if (requestedCapacity <= 0) throw std::invalid_argument("Capacity must be positive");
+        capacity = RoundUpToPowerOfTwo(static_cast<std::size_t>(requestedCapacity));
+        mask = capacity - 1;
+        slots = std::make_unique<T[]>(capacity);
+    }
+
+    SpscQueue(const SpscQueue<T>&) = delete;
+    SpscQueue<T>& operator=(const SpscQueue<T>&) = delete;
+
+    // Только поток-производитель
+    bool TryEnqueue(const T& item) { return TryEnqueueImpl(item); }
+    bool TryEnqueue(T&& item) { return TryEnqueueImpl(std::move(item)); }
+
+    void Enqueue(const T& item) {
+        while (!TryEnqueue(item)) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Только поток-потребитель
+    bool TryDequeue(T& out) {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (!HasItem(h)) return false;
+        out = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    T Dequeue() {
+        T item;
+        while (!TryDequeue(item)) {
+            std::this_thread::yield();
+        }
+        return item;
+    }
+
+    T Peek() {
+        std::size_t h = head.load(std::memory_order_relaxed);
+        if (!HasItem(h)) throw std::out_of_range("Queue is empty");
+        return slots[h & mask];
+    }
+
+    // Из любого потока значение приблизительное
+    int GetLength() const {
+        std::size_t h = head.load(std::memory_order_acquire);
+        std::size_t t = tail.load(std::memory_order_acquire);
+        return static_cast<int>(t - h);
+    }
+
+    bool IsEmpty() const { return GetLength() == 0; }
+    int GetCapacity() const { return static_cast<int>(capacity); }
+};
+
+// ==================== ОЧЕРЕДЬ MPMC (БЕЗ БЛОКИРОВОК) ====================
+
+// Ограниченная очередь для многих производителей и потребителей (схема Вьюкова).
+// У каждой ячейки свой счётчик sequence: sequence == pos — ячейка свободна для
+// записи на позицию pos, sequence == pos + 1 — в ней лежит элемент для чтения.
+// Позиции захватываются CAS'ом; пакетные операции захватывают сразу диапазон.
+template <typename T>
+class MpmcQueue {
+private:
+    struct Cell {
+        std::atomic<std::size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    std::size_t capacity;
+    std::size_t mask;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqueuePos{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> dequeuePos{0};
+
+    static std::ptrdiff_t Distance(std::size_t sequence, std::size_t expected) {
+        return static_cast<std::ptrdiff_t>(sequence - expected);
+    }
+
+    // Захватывает до maxCount подряд идущих позиций, чьи ячейки готовы
+    // (sequence == pos + i + readyOffset). Возвращает число захваченных позиций.
+    int Claim(std::atomic<std::size_t>& position, std::size_t readyOffset, int maxCount, std::size_t& start) {
+        if (maxCount <= 0) return 0;
+        std::size_t pos = position.load(std::memory_order_relaxed);
+        for (;;) {
+            int ready = 0;
+            while (ready < maxCount) {
+                std::size_t seq = cells[(pos + ready) & mask].sequence.load(std::memory_order_acquire);
+                if (Distance(seq, pos + ready + readyOffset) != 0) break;
+                ready++;
+            }
+
+            if (ready == 0) {
+                std::size_t seq = cells[pos & mask].sequence.load(std::memory_order_acquire);
+                if (Distance(seq, pos + readyOffset) < 0) return 0;
+                pos = position.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            if (position.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                start = pos;
+                return ready;
+            }
+        }
+    }
+
+public:
+    explicit MpmcQueue(int requestedCapacity) {
+        if (requestedCapacity < 2) throw std::invalid_argument("Capacity must be at least 2");
+        capacity = 1;
+        while (capacity < static_cast<std::size_t>(requestedCapacity)) capacity <<= 1;
+        mask = capacity - 1;
+        cells = std::make_unique<Cell[]>(capacity);
+        for (std::size_t i = 0; i < capacity; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue<T>&) = delete;
+    MpmcQueue<T>& operator=(const MpmcQueue<T>&) = delete;
+
+    bool TryEnqueue(const T& item) {
+        return TryEnqueueN(&item, 1) == 1;
+    }
+
+    bool TryDequeue(T& out) {
+        return TryDequeueN(&out, 1) == 1;
+    }
+
+    // Кладёт первые k из count элементов одним CAS; k == 0, если очередь полна
+    int TryEnqueueN(const T* items, int count) {
+        std::size_t start = 0;
+        int claimed = Claim(enqueuePos, 0, count, start);
+        for (int i = 0; i < claimed; i++) {
+            Cell& cell = cells[(start + i) & mask];
+            cell.data = items[i];
+            cell.sequence.store(start + i + 1, std::memory_order_release);
+        }
+        return claimed;
+    }
+
+    // Забирает до maxCount элементов одним CAS; 0, если очередь пуста
+    int TryDequeueN(T* out, int maxCount) {
+        std::size_t start = 0;
+        int claimed = Claim(dequeuePos, 1, maxCount, start);
+        for (int i = 0; i < claimed; i++) {
+            Cell& cell = cells[(start + i) & mask];
+            out[i] = std::move(cell.data);
+            cell.sequence.store(start + i + capacity, std::memory_order_release);
+        }
+        return claimed;
+    }
+
+    void Enqueue(const T& item) {
+        while (!TryEnqueue(item)) {
+            std::this_thread::yield();
+        }
+    }
+
+    T Dequeue() {
+        T item;
+        while (!TryDequeue(item)) {
+            std::this_thread::yield();
+        }
+        return item;
+    }
+
+    // Значение приблизительное, пока идут параллельные операции
+    int GetLength() const {
+        std::size_t tail = enqueuePos.load(std::memory_order_acquire);
+        std::size_t head = dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? static_cast<int>(tail - head) : 0;
+    }
+
+    bool IsEmpty() const { return GetLength() == 0; }
+    int GetCapacity() const { return static_cast<int>(capacity); }
+};
+
+// ==================== ШИРОКОВЕЩАТЕЛЬНОЕ КОЛЬЦО ====================
+
+// Каждый элемент пишется в кольцо один раз и виден всем подписчикам (схема Disruptor).
+// У каждого подписчика свой курсор — номер последнего прочитанного элемента;
+// производитель не перезаписывает ячейку, пока её не прочёл самый медленный.
+// Производители захватывают номера fetch_add'ом и публикуют ячейку, записывая
+// в published её номер, поэтому их может быть несколько. Подписчики
+// регистрируются до первой записи; не читающий подписчик останавливает запись.
+template <typename T>
+class BroadcastQueue {
+private:
+    struct alignas(CACHE_LINE_SIZE) Cursor {
+        std::atomic<std::int64_t> value{-1};
+    };
+
+    std::unique_ptr<T[]> slots;
+    std::unique_ptr<std::atomic<std::int64_t>[]> published;
+    std::int64_t capacity;
+    std::int64_t mask;
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    std::atomic<bool> started{false};
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> claimed{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> gatingCache{-1};
+
+    std::int64_t MinCursor() const {
+        std::int64_t minimum = claimed.load(std::memory_order_relaxed) - 1;
+        for (const auto& cursor : cursors) {
+            minimum = std::min(minimum, cursor->value.load(std::memory_order_acquire));
+        }
+        return minimum;
+    }
+
+    // Ячейка номера sequence свободна, когда все прочли sequence - capacity
+    bool HasRoom(std::int64_t sequence) {
+        std::int64_t wrapPoint = sequence - capacity;
+        if (gatingCache.load(std::memory_order_relaxed) >= wrapPoint) return true;
+        std::int64_t minimum = MinCursor();
+        gatingCache.store(minimum, std::memory_order_relaxed);
+        return minimum >= wrapPoint;
+    }
+
+    void Publish(std::int64_t sequence, const T& item) {
+        slots[sequence & mask] = item;
+        published[sequence & mask].store(sequence, std::memory_order_release);
+    }
+
+public:
+    // Непрерывный участок кольца; действителен до Commit у своего подписчика
+    struct Span {
+        const T* data = nullptr;
+        int size = 0;
+
+        const T& operator[](int index) const { return data[index]; }
+        const T* begin() const { return data; }
+        const T* end() const { return data + size; }
+    };
+
+    class Consumer {
+    private:
+        BroadcastQueue<T>* queue;
+        Cursor* cursor;
+        std::int64_t next = 0;
+        int pending = 0;
+
+        Consumer(BroadcastQueue<T>* queue, Cursor* cursor) : queue(queue), cursor(cursor) {}
+        friend class BroadcastQueue<T>;
+
+        bool IsPublished(std::int64_t sequence) const {
+            return queue->published[sequence & queue->mask].load(std::memory_order_acquire) == sequence;
+        }
+
+    public:
+        bool TryRead(T& out) {
+            if (!IsPublished(next)) return false;
+            out = queue->slots[next & queue->mask];
+            cursor->value.store(next, std::memory_order_release);
+            next++;
+            pending = 0;
+            return true;
+        }
+
+        T Read() {
+            T item;
+            while (!TryRead(item)) {
+                std::this_thread::yield();
+            }
+            return item;
+        }
+
+        // До maxCount опубликованных элементов подряд без копирования; участок не
+        // переходит через конец кольца. Повторный вызов без Commit вернёт тот же участок.
+        Span ReadBatch(int maxCount) {
+            std::int64_t untilEnd = queue->capacity - (next & queue->mask);
+            std::int64_t limit = std::min<std::int64_t>(maxCount, untilEnd);
+            int count = 0;
+            while (count < limit && IsPublished(next + count)) {
+                count++;
+            }
+            pending = count;
+            return Span{&queue->slots[next & queue->mask], count};
+        }
+
+        // Освобождает участок последнего ReadBatch для производителей
+        void Commit() {
+            if (pending == 0) return;
+            next += pending;
+            cursor->value.store(next - 1, std::memory_order_release);
+            pending = 0;
+        }
+
+        // Сколько опубликованных элементов ещё не прочитано
+        std::int64_t GetLag() const {
+            return queue->claimed.load(std::memory_order_acquire) - next;
+        }
+    };
+
+    explicit BroadcastQueue(int requestedCapacity) {
+        if (requestedCapacity < 1) throw std::invalid_argument("Capacity must be positive");
+        capacity = 1;
+        while (capacity < requestedCapacity) capacity <<= 1;
+        mask = capacity - 1;
+        slots = std::make_unique<T[]>(capacity);
+        published = std::make_unique<std::atomic<std::int64_t>[]>(capacity);
+        for (std::int64_t i = 0; i < capacity; i++) {
+            published[i].store(-1, std::memory_order_relaxed);
+        }
+    }
+
+    BroadcastQueue(const BroadcastQueue<T>&) = delete;
+    BroadcastQueue<T>& operator=(const BroadcastQueue<T>&) = delete;
+
+    Consumer Subscribe() {
+        if (started.load()) throw std::logic_error("Subscribe must precede the first Enqueue");
+        cursors.push_back(std::make_unique<Cursor>());
+        return Consumer(this, cursors.back().get());
+    }
+
+    void Enqueue(const T& item) {
+        if (!started.load(std::memory_order_relaxed)) started.store(true);
+        std::int64_t sequence = claimed.fetch_add(1, std::memory_order_relaxed);
+        while (!HasRoom(sequence)) {
+            std::this_thread::yield();
+        }
+        Publish(sequence, item);
+    }
+
+    bool TryEnqueue(const T& item) {
+        if (!started.load(std::memory_order_relaxed)) started.store(true);
+        std::int64_t sequence = claimed.load(std::memory_order_relaxed);
+        do {
+            if (!HasRoom(sequence)) return false;
+        } while (!claimed.compare_exchange_weak(sequence, sequence + 1, std::memory_order_relaxed));
+        Publish(sequence, item);
+        return true;
+    }
+
+    int GetCapacity() const { return static_cast<int>(capacity); }
+    int GetConsumerCount() const { return static_cast<int>(cursors.size()); }
+};
+
+// ==================== БЛОКИРУЮЩАЯ ОЧЕРЕДЬ ====================
+
+// Потокобезопасная обёртка над Queue<T> (хранение RING) с ограничением ёмкости.
+// Ждущие потоки считаются, и notify_one вызывается ровно для тех, кто может
+// продвинуться, — без notify_all на каждую операцию. notify_all только в Close().
+template <typename T>
+class BlockingQueue {
+public:
+    enum OverflowPolicy { BLOCK, REJECT, DROP_OLDEST };
+
+private:
+    Queue<T> queue;
+    int capacity;
+    OverflowPolicy policy;
+    bool closed = false;
+    int waitingConsumers = 0;
+    int waitingProducers = 0;
+    long long droppedCount = 0;
+    long long rejectedCount = 0;
+
+    mutable std::mutex mutex;
+    std::condition_variable notEmpty;
+    std::condition_variable notFull;
+
+    bool IsFull() const {
+        return capacity > 0 && queue.GetLength() >= capacity;
+    }
+
+    static void Wake(std::condition_variable& condition, int count) {
+        for (int i = 0; i < count; i++) {
+            condition.notify_one();
+        }
+    }
+
+public:
+    // capacity <= 0 — без ограничения
+    explicit BlockingQueue(int capacity = 0, OverflowPolicy policy = BLOCK)
+        : queue(Queue<T>::RING), capacity(capacity), policy(policy) {}
+
+    BlockingQueue(const BlockingQueue<T>&) = delete;
+    BlockingQueue<T>& operator=(const BlockingQueue<T>&) = delete;
+
+    // false — очередь закрыта или элемент отклонён политикой REJECT
+    bool Enqueue(const T& item) {
+        int wake = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (closed) return false;
+            if (IsFull()) {
+                if (policy == REJECT) {
+                    rejectedCount++;
+                    return false;
+                } else if (policy == DROP_OLDEST) {
+                    queue.Dequeue();
+                    droppedCount++;
+                } else {
+                    waitingProducers++;
+                    notFull.wait(lock, [&]() { return closed || !IsFull(); });
+                    waitingProducers--;
+                    if (closed) return false;
+                }
+            }
+            queue.Enqueue(item);
+            wake = std::min(1, waitingConsumers);
+        }
+        Wake(notEmpty, wake);
+        return true;
+    }
+
+    // Ждёт элемент не дольше timeout; false — истёк таймаут или очередь закрыта и пуста
+    bool Dequeue(T& out, std::chrono::milliseconds timeout) {
+        int wake = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (queue.IsEmpty() && !closed) {
+                waitingConsumers++;
+                notEmpty.wait_for(lock, timeout, [&]() { return closed || !queue.IsEmpty(); });
+                waitingConsumers--;
+            }
+            if (queue.IsEmpty()) return false;
+            out = queue.Dequeue();
+            wake = std::min(1, waitingProducers);
+        }
+        Wake(notFull, wake);
+        return true;
+    }
+
+    T Dequeue() {
+        T item;
+        int wake = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (queue.IsEmpty() && !closed) {
+                waitingConsumers++;
+                notEmpty.wait(lock, [&]() { return closed || !queue.IsEmpty(); });
+                waitingConsumers--;
+            }
+            if (queue.IsEmpty()) throw std::runtime_error("Queue is closed");
+            item = queue.Dequeue();
+            wake = std::min(1, waitingProducers);
+        }
+        Wake(notFull, wake);
+        return item;
+    }
+
+    // Ждёт хотя бы один элемент и забирает до maxCount за одну блокировку.
+    // 0 — очередь закрыта и пуста, поэтому maxCount меньше 1 запрещён.
+    int DequeueBatch(int maxCount, Sequence<T>& out) {
+        if (maxCount < 1) throw std::invalid_argument("maxCount must be at least 1");
+        int taken = 0;
+        int wake = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (queue.IsEmpty() && !closed) {
+                waitingConsumers++;
+                notEmpty.wait(lock, [&]() { return closed || !queue.IsEmpty(); });
+                waitingConsumers--;
+            }
+            while (taken < maxCount && !queue.IsEmpty()) {
+                out.Append(queue.Dequeue());
+                taken++;
+            }
+            wake = std::min(taken, waitingProducers);
+        }
+        Wake(notFull, wake);
+        return taken;
+    }
+
+    // Кладёт элементы по порядку, захватывая блокировку один раз на каждую порцию,
+    // которая помещается. Возвращает число принятых: меньше длины, если очередь
+    // закрыта или часть отклонена политикой REJECT.
+    int EnqueueBatch(const Sequence<T>& items) {
+        int total = items.GetLength();
+        int accepted = 0;
+        int unannounced = 0;
+        bool stopped = false;
+        std::unique_lock<std::mutex> lock(mutex);
+        // Один проход ForEach; блокировка отпускается только на ожидании места
+        items.ForEach([&](const T& item) {
+            if (stopped) return;
+            if (IsFull() && policy == BLOCK && !closed) {
+                Wake(notEmpty, std::min(unannounced, waitingConsumers));
+                unannounced = 0;
+                waitingProducers++;
+                notFull.wait(lock, [&]() { return closed || !IsFull(); });
+                waitingProducers--;
+            }
+            if (closed) {
+                stopped = true;
+                return;
+            }
+            if (IsFull()) {
+                if (policy == REJECT) {
+                    rejectedCount += total - accepted;
+                    stopped = true;
+                    return;
+                }
+                queue.Dequeue();
+                droppedCount++;
+            }
+            queue.Enqueue(item);
+            accepted++;
+            unannounced++;
+        });
+        int wake = std::min(unannounced, waitingConsumers);
+        lock.unlock();
+        Wake(notEmpty, wake);
+        return accepted;
+    }
+
+    // Будит всех ждущих; оставшиеся элементы можно дочитать
+    void Close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closed = true;
+        }
+        notEmpty.notify_all();
+        notFull.notify_all();
+    }
+
+    bool IsClosed() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return closed;
+    }
+
+    int GetLength() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.GetLength();
+    }
+
+    bool IsEmpty() const { return GetLength() == 0; }
+    int GetCapacity() const { return capacity; }
+
+    long long GetDroppedCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return droppedCount;
+    }
+
+    long long GetRejectedCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return rejectedCount;
+    }
+};
+
+// ==================== КОНВЕЙЕР ====================
+
+// Цепочка Source -> Map/Where ... -> Sink, где каждая стадия работает в своём
+// потоке, а соседние стадии связаны ограниченными BlockingQueue. Элементы ходят
+// пачками по batchSize: одна блокировка на пачку с обеих сторон очереди.
+// Метрики стадий можно снимать во время работы; узкое место — стадия с
+// наибольшей долей занятого времени, перед ней копится очередь.
+template <typename T>
+class Pipeline {
+public:
+    struct StageMetrics {
+        std::string name;
+        long long processed = 0;
+        long long emitted = 0;
+        int backlog = 0;
+        double busyFraction = 0;
+        double throughput = 0;
+    };
+
+private:
+    enum StageKind { SOURCE, MAP, WHERE, SINK };
+
+    struct Stage {
+        std::string name;
+        StageKind kind;
+        std::function<bool(T&)> source;
+        const Sequence<T>* items = nullptr;
+        std::function<T(T)> map;
+        std::function<bool(T)> where;
+        std::function<void(const T&)> sink;
+        std::unique_ptr<BlockingQueue<T>> input;
+        std::atomic<long long> processed{0};
+        std::atomic<long long> emitted{0};
+        std::atomic<long long> busyNanos{0};
+    };
+
+    int queueCapacity;
+    int batchSize;
+    std::vector<std::unique_ptr<Stage>> stages;
+    std::vector<std::thread> threads;
+    std::chrono::steady_clock::time_point startTime;
+    std::atomic<long long> finishedNanos{0};
+
+    std::mutex errorMutex;
+    std::exception_ptr error;
+
+    Stage& AddStage(std::string name, StageKind kind) {
+        if (!threads.empty()) throw std::logic_error("Pipeline is already running");
+        if (kind == SOURCE && !stages.empty()) throw std::logic_error("Source must be the first stage");
+        if (kind != SOURCE && stages.empty()) throw std::logic_error("Pipeline must start with a source");
+        if (!stages.empty() && stages.back()->kind == SINK) throw std::logic_error("Sink must be the last stage");
+
+        auto stage = std::make_unique<Stage>();
+        stage->name = std::move(name);
+        stage->kind = kind;
+        if (kind != SOURCE) {
+            stage->input = std::make_unique<BlockingQueue<T>>(queueCapacity);
+        }
+        stages.push_back(std::move(stage));
+        return *stages.back();
+    }
+
+    static long long NanosSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Первая ошибка сохраняется, все очереди закрываются, чтобы остальные стадии вышли
+    void Fail(std::exception_ptr failure) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) error = failure;
+        }
+        for (auto& stage : stages) {
+            if (stage->input) stage->input->Close();
+        }
+    }
+
+    // Пачка уходит в следующую стадию; false — она закрыта
+    bool Emit(size_t index, ArraySequence<T>& batch) {
+        Stage& stage = *stages[index];
+        bool delivered = true;
+        if (batch.GetLength() > 0) {
+            stage.emitted += batch.GetLength();
+            delivered = stages[index + 1]->input->EnqueueBatch(batch) == batch.GetLength();
+            batch.Clear();
+        }
+        return delivered;
+    }
+
+    // Готовая последовательность обходится одним ForEach: Get(i) у списка дал бы O(n²)
+    void RunSequenceSource(size_t index) {
+        Stage& stage = *stages[index];
+        ArraySequence<T> batch;
+        bool open = true;
+        auto busyStart = std::chrono::steady_clock::now();
+        stage.items->ForEach([&](const T& item) {
+            if (!open) return;
+            batch.Append(item);
+            stage.processed++;
+            if (batch.GetLength() == batchSize) {
+                stage.busyNanos += NanosSince(busyStart);
+                open = Emit(index, batch);
+                busyStart = std::chrono::steady_clock::now();
+            }
+        });
+        stage.busyNanos += NanosSince(busyStart);
+        if (open) Emit(index, batch);
+    }
+
+    void RunSource(size_t index) {
+        Stage& stage = *stages[index];
+        if (stage.items) {
+            RunSequenceSource(index);
+            stages[index + 1]->input->Close();
+            return;
+        }
+        ArraySequence<T> batch;
+        T item;
+        for (;;) {
+            auto busyStart = std::chrono::steady_clock::now();
+            bool more = true;
+            while (batch.GetLength() < batchSize && (more = stage.source(item))) {
+                batch.Append(item);
+                stage.processed++;
+            }
+            stage.busyNanos += NanosSince(busyStart);
+            if (!Emit(index, batch) || !more) break;
+        }
+        stages[index + 1]->input->Close();
+    }
+
+    void RunStage(size_t index) {
+        Stage& stage = *stages[index];
+        ArraySequence<T> in;
+        ArraySequence<T> out;
+        while (stage.input->DequeueBatch(batchSize, in) > 0) {
+            auto busyStart = std::chrono::steady_clock::now();
+            for (int i = 0; i < in.GetLength(); i++) {
+                const T& item = in[i];
+                if (stage.kind == MAP) {
+                    out.Append(stage.map(item));
+                } else if (stage.kind == WHERE) {
+                    if (stage.where(item)) out.Append(item);
+                } else {
+                    stage.sink(item);
+                }
+            }
+            stage.processed += in.GetLength();
+            in.Clear();
+            stage.busyNanos += NanosSince(busyStart);
+            if (stage.kind != SINK && !Emit(index, out)) break;
+        }
+        if (stage.kind != SINK) {
+            stages[index + 1]->input->Close();
+        }
+    }
+
+public:
+    explicit Pipeline(int queueCapacity = 1024, int batchSize = 64)
+        : queueCapacity(queueCapacity), batchSize(std::max(1, batchSize)) {}
+
+    Pipeline(const Pipeline<T>&) = delete;
+    Pipeline<T>& operator=(const Pipeline<T>&) = delete;
+
+    ~Pipeline() {
+        if (!threads.empty()) {
+            for (auto& stage : stages) {
+                if (stage->input) stage->input->Close();
+            }
+            for (auto& thread : threads) {
+                if (thread.joinable()) thread.join();
+            }
+        }
+    }
+
+    // next(item) заполняет очередной элемент; false — источник исчерпан
+    Pipeline<T>& Source(std::function<bool(T&)> next, const std::string& name = "Source") {
+        AddStage(name, SOURCE).source = std::move(next);
+        return *this;
+    }
+
+    // Последовательность должна жить до конца Wait()
+    Pipeline<T>& Source(const Sequence<T>& items, const std::string& name = "Source") {
+        AddStage(name, SOURCE).items = &items;
+        return *this;
+    }
+
+    Pipeline<T>& Map(std::function<T(T)> func, const std::string& name = "Map") {
+        AddStage(name, MAP).map = std::move(func);
+        return *this;
+    }
+
+    Pipeline<T>& Where(std::function<bool(T)> predicate, const std::string& name = "Where") {
+        AddStage(name, WHERE).where = std::move(predicate);
+        return *this;
+    }
+
+    Pipeline<T>& Sink(std::function<void(const T&)> consumer, const std::string& name = "Sink") {
+        AddStage(name, SINK).sink = std::move(consumer);
+        return *this;
+    }
+
+    Pipeline<T>& Sink(Sequence<T>& out, const std::string& name = "Sink") {
+        return Sink([&out](const T& item) { out.Append(item); }, name);
+    }
+
+    void Start() {
+        if (!threads.empty()) throw std::logic_error("Pipeline is already running");
+        if (stages.size() < 2 || stages.back()->kind != SINK) {
+            throw std::logic_error("Pipeline needs a source and a sink");
+        }
+        startTime = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < stages.size(); i++) {
+            threads.emplace_back([this, i]() {
+                try {
+                    if (i == 0) {
+                        RunSource(i);
+                    } else {
+                        RunStage(i);
+                    }
+                } catch (...) {
+                    Fail(std::current_exception());
+                }
+            });
+        }
+    }
+
+    // Ждёт окончания всех стадий; исключение стадии пробрасывается отсюда
+    void Wait() {
+        for (auto& thread : threads) {
+            if (thread.joinable()) thread.join();
+        }
+        finishedNanos = NanosSince(startTime);
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (error) std::rethrow_exception(error);
+    }
+
+    void Run() {
+        Start();
+        Wait();
+    }
+
+    std::vector<StageMetrics> GetMetrics() const {
+        long long elapsed = finishedNanos.load();
+        if (elapsed == 0 && !threads.empty()) elapsed = NanosSince(startTime);
+        std::vector<StageMetrics> result;
+        for (const auto& stage : stages) {
+            StageMetrics metrics;
+            metrics.name = stage->name;
+            metrics.processed = stage->processed.load();
+            metrics.emitted = stage->emitted.load();
+            metrics.backlog = stage->input ? stage->input->GetLength() : 0;
+            if (elapsed > 0) {
+                metrics.busyFraction = static_cast<double>(stage->busyNanos.load()) / elapsed;
+                metrics.throughput = metrics.processed * 1e9 / elapsed;
+            }
+            result.push_back(metrics);
+        }
+        return result;
+    }
+
+    // Имя стадии с наибольшей долей занятого времени
+    std::string GetBottleneck() const {
+        std::vector<StageMetrics> metrics = GetMetrics();
+        std::string name;
+        double busiest = -1;
+        for (const auto& stage : metrics) {
+            if (stage.busyFraction > busiest) {
+                busiest = stage.busyFraction;
+                name = stage.name;
+            }
+        }
+        return name;
+    }
+
+    std::string MetricsReport() const {
+        std::stringstream ss;
+        ss << std::fixed << std::setprecision(1);
+        for (const auto& stage : GetMetrics()) {
+            ss << stage.name << ": обработано " << stage.processed << ", передано " << stage.emitted
+               << ", в очереди " << stage.backlog << ", занято " << stage.busyFraction * 100 << "%, "
+               << stage.throughput / 1000 << " тыс./с\n";
+        }
+        ss << "Узкое место: " << GetBottleneck();
+        return ss.str();
+    }
+};
+
+// ==================== ДЕК CHASE-LEV ====================
+
+// Дек для планировщика с кражей работы (Chase-Lev; порядок памяти по Lê и др., 2013).
+// Владелец кладёт и забирает с нижнего конца (LIFO), любые другие потоки крадут
+// с верхнего (FIFO). Ячейки — атомики, поэтому T должен быть тривиально копируемым.
+template <typename T>
+class WorkStealingDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "WorkStealingDeque requires trivially copyable T");
+
+private:
+    struct Buffer {
+        std::int64_t capacity;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        explicit Buffer(std::int64_t capacity)
+            : capacity(capacity), slots(std::make_unique<std::atomic<T>[]>(capacity)) {}
+
+        T Get(std::int64_t index) const {
+            return slots[index & (capacity - 1)].load(std::memory_order_relaxed);
+        }
+
+        void Put(std::int64_t index, T value) {
+            slots[index & (capacity - 1)].store(value, std::memory_order_relaxed);
+        }
+    };
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> top{0};
+    alignas(CACHE_LINE_SIZE) std::atomic<std::int64_t> bottom{0};
+    std::atomic<Buffer*> buffer;
+    // Старые буферы живут до разрушения дека: вор мог успеть взять на них указатель
+    std::vector<std::unique_ptr<Buffer>> buffers;
+
+    Buffer* Grow(Buffer* old, std::int64_t b, std::int64_t t) {
+        auto grown = std::make_unique<Buffer>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; i++) {
+            grown->Put(i, old->Get(i));
+        }
+        Buffer* result = grown.get();
+        buffers.push_back(std::move(grown));
+        buffer.store(result, std::memory_order_release);
+        return result;
+    }
+
+public:
+    explicit WorkStealingDeque(int initialCapacity = 64) {
+        std::int64_t capacity = 1;
+        while (capacity < initialCapacity) capacity <<= 1;
+        buffers.push_back(std::make_unique<Buffer>(capacity));
+        buffer.store(buffers.back().get(), std::memory_order_relaxed);
+    }
+
+    WorkStealingDeque(const WorkStealingDeque<T>&) = delete;
+    WorkStealingDeque<T>& operator=(const WorkStealingDeque<T>&) = delete;
+
+    // Только поток-владелец
+    void Push(T item) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_acquire);
+        Buffer* a = buffer.load(std::memory_order_relaxed);
+        if (b - t > a->capacity - 1) {
+            a = Grow(a, b, t);
+        }
+        a->Put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+
+    // Только поток-владелец
+    bool TryPop(T& out) {
+        std::int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        Buffer* a = buffer.load(std::memory_order_relaxed);
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+
+        out = a->Get(b);
+        if (t == b) {
+            // Последний элемент: соревнуемся с ворами за top
+            bool won = top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed);
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    // Из любого потока
+    bool TrySteal(T& out) {
+        std::int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) return false;
+
+        Buffer* a = buffer.load(std::memory_order_acquire);
+        T item = a->Get(t);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
+    }
+
+    int GetLength() const {
+        std::int64_t b = bottom.load(std::memory_order_relaxed);
+        std::int64_t t = top.load(std::memory_order_relaxed);
+        return b > t ? static_cast<int>(b - t) : 0;
+    }
+
+    bool IsEmpty() const { return GetLength() == 0; }
+};
+
+// ==================== ПУЛ ПОТОКОВ С КРАЖЕЙ РАБОТЫ ====================
+
+// У каждого рабочего потока свой WorkStealingDeque задач. Задачи из рабочих
+// потоков кладутся в собственный дек, из внешних — в общую MpmcQueue. Поток
+// без работы берёт свою задачу, затем из общей очереди, затем крадёт у других.
+// Задачи не должны бросать исключения.
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Worker {
+        WorkStealingDeque<Task*> deque;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    MpmcQueue<Task*> injection;
+    std::atomic<long long> pendingTasks{0};
+    std::atomic<long long> submitEpoch{0};
+    std::atomic<int> sleepingWorkers{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+
+    std::atomic<long long> executedCount{0};
+    std::atomic<long long> stealCount{0};
+    std::atomic<long long> idleMicroseconds{0};
+
+    inline static thread_local WorkStealingPool* currentPool = nullptr;
+    inline static thread_local int currentWorker = -1;
+
+    int CurrentWorker() const {
+        return currentPool == this ? currentWorker : -1;
+    }
+
+    bool FindTask(int self, Task*& task) {
+        if (self >= 0 && workers[self]->deque.TryPop(task)) return true;
+        if (injection.TryDequeue(task)) return true;
+
+        thread_local std::minstd_rand random(std::random_device{}());
+        int count = static_cast<int>(workers.size());
+        int start = static_cast<int>(random() % count);
+        for (int i = 0; i < count; i++) {
+            int victim = (start + i) % count;
+            if (victim != self && workers[victim]->deque.TrySteal(task)) {
+                stealCount++;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void Execute(Task* task) {
+        std::unique_ptr<Task> owned(task);
+        (*owned)();
+        executedCount++;
+        pendingTasks--;
+    }
+
+    // Выполнить одну найденную задачу в текущем потоке, пока он чего-то ждёт
+    bool RunOneTask() {
+        Task* task = nullptr;
+        if (!FindTask(CurrentWorker(), task)) return false;
+        Execute(task);
+        return true;
+    }
+
+    void WorkerLoop(int index) {
+        currentPool = this;
+        currentWorker = index;
+
+        for (;;) {
+            long long epoch = submitEpoch.load();
+            Task* task = nullptr;
+            if (FindTask(index, task)) {
+                Execute(task);
+                continue;
+            }
+            if (stopping.load() && pendingTasks.load() == 0) break;
+
+            auto idleStart = std::chrono::steady_clock::now();
+            {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                sleepingWorkers++;
+                wakeCondition.wait_for(lock, std::chrono::milliseconds(1), [&]() {
+                    return stopping.load() || submitEpoch.load() != epoch;
+                });
+                sleepingWorkers--;
+            }
+            auto idle = std::chrono::steady_clock::now() - idleStart;
+            idleMicroseconds += std::chrono::duration_cast<std::chrono::microseconds>(idle).count();
+        }
+    }
+
+public:
+    explicit WorkStealingPool(int threadCount = 0) : injection(1024) {
+        if (threadCount <= 0) {
+            threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        }
+        for (int i = 0; i < threadCount; i++) {
+            workers.push_back(std::make_unique<Worker>());
+        }
+        for (int i = 0; i < threadCount; i++) {
+            workers[i]->thread = std::thread(&WorkStealingPool::WorkerLoop, this, i);
+        }
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    // Дожидается всех отправленных задач
+    ~WorkStealingPool() {
+        stopping = true;
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wakeCondition.notify_all();
+        for (auto& worker : workers) {
+            worker->thread.join();
+        }
+    }
+
+    void Submit(Task task) {
+        Task* raw = new Task(std::move(task));
+        pendingTasks++;
+
+        int self = CurrentWorker();
+        if (self >= 0) {
+            workers[self]->deque.Push(raw);
+        } else {
+            while (!injection.TryEnqueue(raw)) {
+                std::this_thread::yield();
+            }
+        }
+
+        submitEpoch++;
+        if (sleepingWorkers.load() > 0) {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            wakeCondition.notify_one();
+        }
+    }
+
+    // Вызывается вне задач пула; ожидающий поток сам выполняет задачи
+    void Wait() {
+        while (pendingTasks.load() > 0) {
+            if (!RunOneTask()) std::this_thread::yield();
+        }
+    }
+
+    // Вызывает body(i) для i из [begin, end). Диапазон рекурсивно делится пополам:
+    // одна половина уходит в дек (её могут украсть), другую поток делит дальше.
+    // Можно вызывать и из задачи пула.
+    void ParallelFor(int begin, int end, const std::function<void(int)>& body, int grain = 0) {
+        if (begin >= end) return;
+        if (grain <= 0) {
+            grain = std::max(1, (end - begin) / (8 * GetThreadCount()));
+        }
+
+        std::atomic<int> remaining{end - begin};
+        std::function<void(int, int)> run = [&](int from, int to) {
+            while (to - from > grain) {
+                int mid = from + (to - from) / 2;
+                Submit([&run, mid, to]() { run(mid, to); });
+                to = mid;
+            }
+            for (int i = from; i < to; i++) {
+                body(i);
+            }
+            // Последнее обращение к локальным переменным ParallelFor
+            remaining.fetch_sub(to - from, std::memory_order_acq_rel);
+        };
+
+        run(begin, end);
+        while (remaining.load(std::memory_order_acquire) > 0) {
+            if (!RunOneTask()) std::this_thread::yield();
+        }
+    }
+
+    int GetThreadCount() const { return static_cast<int>(workers.size()); }
+    long long GetExecutedCount() const { return executedCount.load(); }
+    long long GetStealCount() const { return stealCount.load(); }
+    std::chrono::microseconds GetIdleTime() const {
+        return std::chrono::microseconds(idleMicroseconds.load());
+    }
+};
+
+#if defined(__cpp_impl_coroutine)
+
+// ==================== ОЧЕРЕДЬ ДЛЯ КОРУТИН ====================
+
+// Корутина «запустил и забыл»: стартует сразу, кадр освобождается по завершении
+struct AsyncTask {
+    struct promise_type {
+        AsyncTask get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+// co_await queue.DequeueAsync() приостанавливает корутину-потребителя, пока в
+// очереди нет элементов. Enqueue отдаёт элемент первому ждущему напрямую и
+// возобновляет его в пуле-исполнителе, а не в потоке производителя. Ждущие
+// связаны в список через сами awaiter'ы, лежащие в кадрах корутин.
+template <typename T>
+class AsyncQueue {
+public:
+    class DequeueAwaiter {
+    private:
+        AsyncQueue<T>& queue;
+        std::coroutine_handle<> handle;
+        DequeueAwaiter* next = nullptr;
+        T result;
+
+        friend class AsyncQueue<T>;
+
+    public:
+        explicit DequeueAwaiter(AsyncQueue<T>& queue) : queue(queue) {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> awaiting) {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.items.IsEmpty()) {
+                result = queue.items.Dequeue();
+                return false;
+            }
+            handle = awaiting;
+            if (queue.lastWaiter) {
+                queue.lastWaiter->next = this;
+            } else {
+                queue.firstWaiter = this;
+            }
+            queue.lastWaiter = this;
+            queue.waiterCount++;
+            return true;
+        }
+
+        T await_resume() { return std::move(result); }
+    };
+
+private:
+    Queue<T> items;
+    DequeueAwaiter* firstWaiter = nullptr;
+    DequeueAwaiter* lastWaiter = nullptr;
+    int waiterCount = 0;
+    WorkStealingPool& executor;
+    mutable std::mutex mutex;
+
+public:
+    explicit AsyncQueue(WorkStealingPool& executor) : items(Queue<T>::RING), executor(executor) {}
+
+    AsyncQueue(const AsyncQueue<T>&) = delete;
+    AsyncQueue<T>& operator=(const AsyncQueue<T>&) = delete;
+
+    void Enqueue(const T& item) {
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!firstWaiter) {
+                items.Enqueue(item);
+                return;
+            }
+            DequeueAwaiter* waiter = firstWaiter;
+            firstWaiter = waiter->next;
+            if (!firstWaiter) lastWaiter = nullptr;
+            waiterCount--;
+            waiter->result = item;
+            handle = waiter->handle;
+        }
+        executor.Submit([handle]() { handle.resume(); });
+    }
+
+    DequeueAwaiter DequeueAsync() {
+        return DequeueAwaiter(*this);
+    }
+
+    int GetLength() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return items.GetLength();
+    }
+
+    int GetWaiterCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return waiterCount;
+    }
+};
+
+#endif
+
+#if defined(__linux__)
+
+// ==================== ОЧЕРЕДЬ В РАЗДЕЛЯЕМОЙ ПАМЯТИ ====================
+
+// Кольцо MPMC (схема с sequence в ячейках, как у MpmcQueue) в сегменте POSIX
+// shared memory, который процессы открывают по имени. Ожидание — futex на
+// счётчиках сигналов в заголовке; пока данные есть, системных вызовов нет.
+template <typename T>
+class SharedMemoryQueue {
+    static_assert(std::is_trivially_copyable_v<T>, "SharedMemoryQueue requires trivially copyable T");
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Cross-process atomics must be lock-free");
+
+private:
+    static constexpr std::uint32_t MAGIC = 0x4C423351;
+
+    struct Cell {
+        std::atomic<std::uint64_t> sequence;
+        T data;
+    };
+
+    struct Header {
+        std::atomic<std::uint32_t> magic;
+        std::uint32_t elementSize;
+        std::uint64_t capacity;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> enqueuePos;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> dequeuePos;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> itemsSignal;
+        std::atomic<std::uint32_t> waitingConsumers;
+        alignas(CACHE_LINE_SIZE) std::atomic<std::uint32_t> spaceSignal;
+        std::atomic<std::uint32_t> waitingProducers;
+    };
+
+    std::string name;
+    int fd = -1;
+    void* memory = nullptr;
+    std::size_t mappedSize = 0;
+    Header* header = nullptr;
+    Cell* cells = nullptr;
+    std::uint64_t mask = 0;
+
+    static std::size_t SegmentSize(std::uint64_t capacity) {
+        return sizeof(Header) + capacity * sizeof(Cell);
+    }
+
+    static std::runtime_error SystemError(const std::string& what) {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    void Map(std::size_t size) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (memory == MAP_FAILED) {
+            auto error = SystemError("mmap " + name);
+            close(fd);
+            throw error;
+        }
+        mappedSize = size;
+        header = static_cast<Header*>(memory);
+        cells = reinterpret_cast<Cell*>(static_cast<char*>(memory) + sizeof(Header));
+    }
+
+    static void FutexWait(std::atomic<std::uint32_t>& word, std::uint32_t expected, const timespec* timeout) {
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+    }
+
+    static void Signal(std::atomic<std::uint32_t>& signal, std::atomic<std::uint32_t>& waiting) {
+        signal.fetch_add(1);
+        if (waiting.load() > 0) {
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&signal), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+        }
+    }
+
+    // Повторяет attempt, засыпая на futex между попытками; deadline == nullptr — без таймаута.
+    // Значение сигнала читается до попытки, поэтому futex не уснёт после пропущенного Signal.
+    template <typename Attempt>
+    static bool WaitUntil(Attempt attempt, std::atomic<std::uint32_t>& signal, std::atomic<std::uint32_t>& waiting,
+                          const std::chrono::steady_clock::time_point* deadline) {
+        for (;;) {
+            std::uint32_t observed = signal.load();
+            waiting.fetch_add(1);
+            if (attempt()) {
+                waiting.fetch_sub(1);
+                return true;
+            }
+
+            timespec timeout{};
+            if (deadline) {
+                auto left = *deadline - std::chrono::steady_clock::now();
+                if (left <= std::chrono::steady_clock::duration::zero()) {
+                    waiting.fetch_sub(1);
+                    return false;
+                }
+                auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+                timeout.tv_sec = nanoseconds / 1000000000;
+                timeout.tv_nsec = nanoseconds % 1000000000;
+            }
+            FutexWait(signal, observed, deadline ? &timeout : nullptr);
+            waiting.fetch_sub(1);
+        }
+    }
+
+public:
+    // Создаёт новый сегмент; существующий с тем же именем — ошибка
+    SharedMemoryQueue(const std::string& name, int requestedCapacity) : name(name) {
+        if (requestedCapacity < 2) throw std::invalid_argument("Capacity must be at least 2");
+        std::uint64_t capacity = 1;
+        while (capacity < static_cast<std::uint64_t>(requestedCapacity)) capacity <<= 1;
+
+        fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) throw SystemError("shm_open " + name);
+        if (ftruncate(fd, SegmentSize(capacity)) != 0) {
+            auto error = SystemError("ftruncate " + name);
+            close(fd);
+            shm_unlink(name.c_str());
+            throw error;
+        }
+        Map(SegmentSize(capacity));
+
+        new (header) Header();
+        header->elementSize = sizeof(T);
+        header->capacity = capacity;
+        mask = capacity - 1;
+        for (std::uint64_t i = 0; i < capacity; i++) {
+            new (&cells[i]) Cell();
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        header->magic.store(MAGIC, std::memory_order_release);
+    }
+
+    // Открывает сегмент, созданный другим процессом
+    explicit SharedMemoryQueue(const std::string& name) : name(name) {
+        fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd < 0) throw SystemError("shm_open " + name);
+
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            auto error = SystemError("fstat " + name);
+            close(fd);
+            throw error;
+        }
+        if (static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+            close(fd);
+            throw std::runtime_error("Shared memory queue is not initialized: " + name);
+        }
+        Map(static_cast<std::size_t>(info.st_size));
+
+        if (header->magic.load(std::memory_order_acquire) != MAGIC || header->elementSize != sizeof(T) ||
+            SegmentSize(header->capacity) > mappedSize) {
+            munmap(memory, mappedSize);
+            close(fd);
+            throw std::runtime_error("Shared memory segment does not hold a queue of this type: " + name);
+        }
+        mask = header->capacity - 1;
+    }
+
+    ~SharedMemoryQueue() {
+        munmap(memory, mappedSize);
+        close(fd);
+    }
+
+    SharedMemoryQueue(const SharedMemoryQueue<T>&) = delete;
+    SharedMemoryQueue<T>& operator=(const SharedMemoryQueue<T>&) = delete;
+
+    // Имя удаляется сразу, память — когда сегмент закроют все процессы
+    static void Unlink(const std::string& name) {
+        shm_unlink(name.c_str());
+    }
+
+    bool TryEnqueue(const T& item) {
+        std::uint64_t pos = header->enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            std::uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::int64_t>(seq - pos);
+            if (diff == 0) {
+                if (header->enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = header->enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        cell->data = item;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        Signal(header->itemsSignal, header->waitingConsumers);
+        return true;
+    }
+
+    bool TryDequeue(T& out) {
+        std::uint64_t pos = header->dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            std::uint64_t seq = cell->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::int64_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (header->dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = header->dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        out = cell->data;
+        cell->sequence.store(pos + header->capacity, std::memory_order_release);
+        Signal(header->spaceSignal, header->waitingProducers);
+        return true;
+    }
+
+    void Enqueue(const T& item) {
+        WaitUntil([&]() { return TryEnqueue(item); }, header->spaceSignal, header->waitingProducers, nullptr);
+    }
+
+    T Dequeue() {
+        T item;
+        WaitUntil([&]() { return TryDequeue(item); }, header->itemsSignal, header->waitingConsumers, nullptr);
+        return item;
+    }
+
+    bool Dequeue(T& out, std::chrono::milliseconds timeout) {
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+        return WaitUntil([&]() { return TryDequeue(out); }, header->itemsSignal, header->waitingConsumers, &deadline);
+    }
+
+    int GetLength() const {
+        std::uint64_t tail = header->enqueuePos.load(std::memory_order_acquire);
+        std::uint64_t head = header->dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? static_cast<int>(tail - head) : 0;
+    }
+
+    bool IsEmpty() const { return GetLength() == 0; }
+    int GetCapacity() const { return static_cast<int>(header->capacity); }
+    const std::string& GetName() const { return name; }
+};
+
+#endif
+
+#if defined(__linux__)
+
+// ==================== АСИНХРОННЫЙ ВВОД-ВЫВОД ====================
+
+// Минимальная обёртка над io_uring без liburing: кольца отображаются напрямую,
+// запросы — через io_uring_setup/io_uring_enter. Один объект — один поток.
+class IoUring {
+private:
+    int ringFd = -1;
+    void* sqRing = MAP_FAILED;
+    void* cqRing = MAP_FAILED;
+    std::size_t sqRingSize = 0;
+    std::size_t cqRingSize = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    std::size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned entries = 0;
+    unsigned unsubmitted = 0;
+
+    void Release() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) close(ringFd);
+    }
+
+    [[noreturn]] void Fail(const std::string& what) {
+        std::string message = what + ": " + std::strerror(errno);
+        Release();
+        throw std::runtime_error(message);
+    }
+
 public:
-    enum StorageType { ARRAY, LINKED_LIST };
+    explicit IoUring(unsigned requestedEntries) {
+        io_uring_params params{};
+        ringFd = static_cast<int>(syscall(__NR_io_uring_setup, requestedEntries, &params));
+        if (ringFd < 0) Fail("io_uring_setup");
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
 
-    Queue(StorageType type = ARRAY) {
-        if (type == ARRAY) {
-            storage = std::make_shared<ArraySequence<T>>();
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) Fail("mmap io_uring sq");
+        cqRing = singleMap ? sqRing
+                           : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED) Fail("mmap io_uring cq");
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                               ringFd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) Fail("mmap io_uring sqes");
+
+        char* sq = static_cast<char*>(sqRing);
+        char* cq = static_cast<char*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        entries = params.sq_entries;
+    }
+
+    ~IoUring() {
+        Release();
+    }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // Ядро может запретить io_uring (seccomp, sysctl) — проверяется один раз
+    static bool IsSupported() {
+        static const bool supported = []() {
+            try {
+                IoUring probe(2);
+                return true;
+            } catch (const std::exception&) {
+                return false;
+            }
+        }();
+        return supported;
+    }
+
+    unsigned GetEntries() const { return entries; }
+
+    void Prepare(std::uint8_t opcode, int fd, const void* buffer, unsigned size, std::uint64_t offset, std::uint64_t userData) {
+        unsigned tail = *sqTail;
+        if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= entries) {
+            throw std::logic_error("io_uring submission queue is full");
+        }
+        unsigned index = tail & *sqMask;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<std::uint64_t>(buffer);
+        sqe.len = size;
+        sqe.off = offset;
+        sqe.user_data = userData;
+        sqArray[index] = index;
+        __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+        unsubmitted++;
+    }
+
+    // Отправляет подготовленные запросы и ждёт не меньше minComplete завершений
+    void Submit(unsigned minComplete) {
+        for (;;) {
+            long submitted = syscall(__NR_io_uring_enter, ringFd, unsubmitted, minComplete,
+                                     minComplete > 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (submitted >= 0) {
+                unsubmitted -= static_cast<unsigned>(submitted);
+                return;
+            }
+            if (errno != EINTR) throw std::runtime_error(std::string("io_uring_enter: ") + std::strerror(errno));
+        }
+    }
+
+    // Дожидается inFlight завершений перед уничтожением буферов; вызывается при ошибке,
+    // поэтому сбой io_uring_enter здесь не бросается — ждать больше нечем
+    void Drain(unsigned& inFlight) {
+        try {
+            while (inFlight > 0) {
+                Submit(1);
+                std::uint64_t userData;
+                int result;
+                while (PopCompletion(userData, result)) {
+                    inFlight--;
+                }
+            }
+        } catch (const std::exception&) {
+        }
+    }
+
+    bool PopCompletion(std::uint64_t& userData, int& result) {
+        unsigned head = *cqHead;
+        if (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) return false;
+        const io_uring_cqe& cqe = cqes[head & *cqMask];
+        userData = cqe.user_data;
+        result = cqe.res;
+        __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+};
+
+enum IoBackend { IO_AUTO, IO_URING, IO_THREAD_POOL };
+
+// Кусок файла в буфере, выровненном по странице
+struct IoChunk {
+    struct FreeDeleter {
+        void operator()(char* pointer) const { std::free(pointer); }
+    };
+
+    static constexpr std::size_t ALIGNMENT = 4096;
+    static constexpr std::size_t CAPACITY = 1 << 20;
+
+    std::unique_ptr<char, FreeDeleter> data;
+    std::size_t size = 0;
+    std::uint64_t offset = 0;
+
+    explicit IoChunk(std::uint64_t offset)
+        : data(static_cast<char*>(std::aligned_alloc(ALIGNMENT, CAPACITY))), offset(offset) {
+        if (!data) throw std::bad_alloc();
+    }
+};
+
+constexpr unsigned IO_QUEUE_DEPTH = 8;
+
+inline bool ResolveUring(IoBackend backend) {
+    if (backend == IO_URING && !IoUring::IsSupported()) throw std::runtime_error("io_uring is not available");
+    return backend == IO_URING || (backend == IO_AUTO && IoUring::IsSupported());
+}
+
+// Пул для запасного пути через pwrite/pread, когда io_uring недоступен
+inline WorkStealingPool& IoThreadPool() {
+    static WorkStealingPool pool(4);
+    return pool;
+}
+
+inline void WriteChunksUring(int fd, const std::vector<IoChunk>& chunks) {
+    IoUring ring(IO_QUEUE_DEPTH);
+    std::vector<std::size_t> written(chunks.size(), 0);
+    std::size_t next = 0;
+    unsigned inFlight = 0;
+
+    try {
+        while (next < chunks.size() || inFlight > 0) {
+            while (next < chunks.size() && inFlight < ring.GetEntries()) {
+                ring.Prepare(IORING_OP_WRITE, fd, chunks[next].data.get(), static_cast<unsigned>(chunks[next].size),
+                             chunks[next].offset, next);
+                next++;
+                inFlight++;
+            }
+            ring.Submit(1);
+
+            std::uint64_t id;
+            int result;
+            while (ring.PopCompletion(id, result)) {
+                inFlight--;
+                if (result < 0) {
+                    errno = -result;
+                    throw std::runtime_error(std::string("io_uring write: ") + std::strerror(errno));
+                }
+                // Короткая запись — дописываем остаток тем же куском
+                written[id] += static_cast<std::size_t>(result);
+                const IoChunk& chunk = chunks[id];
+                if (written[id] < chunk.size) {
+                    ring.Prepare(IORING_OP_WRITE, fd, chunk.data.get() + written[id],
+                                 static_cast<unsigned>(chunk.size - written[id]), chunk.offset + written[id], id);
+                    inFlight++;
+                }
+            }
+        }
+    } catch (...) {
+        // Ядро читает chunks, пока записи в полёте: вызывающий освободит их после throw
+        ring.Drain(inFlight);
+        throw;
+    }
+}
+
+inline void WriteChunksThreadPool(int fd, const std::vector<IoChunk>& chunks) {
+    std::atomic<int> failedErrno{0};
+    IoThreadPool().ParallelFor(0, static_cast<int>(chunks.size()), [&](int i) {
+        const IoChunk& chunk = chunks[i];
+        std::size_t done = 0;
+        while (done < chunk.size) {
+            ssize_t written = pwrite(fd, chunk.data.get() + done, chunk.size - done,
+                                     static_cast<off_t>(chunk.offset + done));
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                failedErrno = errno;
+                return;
+            }
+            done += static_cast<std::size_t>(written);
+        }
+    }, 1);
+    if (failedErrno.load() != 0) {
+        errno = failedErrno.load();
+        throw std::runtime_error(std::string("pwrite: ") + std::strerror(errno));
+    }
+}
+
+// Кодирует снимок в вызывающем потоке (проход по памяти), а запись кусками по 1 МиБ
+// и fdatasync выполняет в фоне. Очередь можно менять сразу после возврата.
+// Результат future — размер файла в байтах.
+template <typename T>
+std::future<std::uint64_t> SerializeBinaryAsync(const Sequence<T>& items, const std::string& filename,
+                                                IoBackend backend = IO_AUTO) {
+    bool useUring = ResolveUring(backend);
+
+    std::vector<IoChunk> chunks;
+    std::uint64_t total = 0;
+    EncodeBinarySnapshot(items, [&](const char* data, std::size_t size) {
+        while (size > 0) {
+            if (chunks.empty() || chunks.back().size == IoChunk::CAPACITY) {
+                chunks.emplace_back(total);
+            }
+            IoChunk& chunk = chunks.back();
+            std::size_t part = std::min(size, IoChunk::CAPACITY - chunk.size);
+            std::memcpy(chunk.data.get() + chunk.size, data, part);
+            chunk.size += part;
+            total += part;
+            data += part;
+            size -= part;
+        }
+    });
+
+    return std::async(std::launch::async, [chunks = std::move(chunks), filename, total, useUring]() {
+        int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) throw std::runtime_error("open " + filename + ": " + std::strerror(errno));
+        try {
+            if (useUring) {
+                WriteChunksUring(fd, chunks);
+            } else {
+                WriteChunksThreadPool(fd, chunks);
+            }
+            if (fdatasync(fd) != 0) throw std::runtime_error("fdatasync " + filename + ": " + std::strerror(errno));
+        } catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        return total;
+    });
+}
+
+// Читает файл кусками по IoChunk::CAPACITY, держа до IO_QUEUE_DEPTH чтений в полёте,
+// и по порядку отдаёт куски consumer(data, size) в вызывающем потоке, пока
+// следующие куски ещё читаются.
+template <typename Consumer>
+void ReadFileAhead(const std::string& filename, Consumer&& consumer, IoBackend backend = IO_AUTO) {
+    bool useUring = ResolveUring(backend);
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::runtime_error("open " + filename + ": " + std::strerror(errno));
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        throw std::runtime_error("fstat " + filename + ": " + std::strerror(errno));
+    }
+    const std::uint64_t fileSize = static_cast<std::uint64_t>(info.st_size);
+    const std::uint64_t chunkCount = (fileSize + IoChunk::CAPACITY - 1) / IoChunk::CAPACITY;
+    auto chunkSize = [&](std::uint64_t index) {
+        return static_cast<std::size_t>(std::min<std::uint64_t>(IoChunk::CAPACITY, fileSize - index * IoChunk::CAPACITY));
+    };
+
+    std::vector<IoChunk> slots;
+    for (unsigned i = 0; i < IO_QUEUE_DEPTH; i++) {
+        slots.emplace_back(0);
+    }
+
+    try {
+        if (useUring) {
+            IoUring ring(IO_QUEUE_DEPTH);
+            std::vector<std::uint64_t> slotChunk(IO_QUEUE_DEPTH);
+            std::vector<bool> ready(IO_QUEUE_DEPTH, false);
+            std::uint64_t nextToRead = 0;
+            unsigned inFlight = 0;
+
+            auto submitRead = [&](unsigned slot, std::uint64_t index) {
+                IoChunk& chunk = slots[slot];
+                chunk.offset = index * IoChunk::CAPACITY;
+                chunk.size = 0;
+                slotChunk[slot] = index;
+                ready[slot] = false;
+                ring.Prepare(IORING_OP_READ, fd, chunk.data.get(), static_cast<unsigned>(chunkSize(index)), chunk.offset, slot);
+                inFlight++;
+            };
+
+            try {
+                for (; nextToRead < chunkCount && nextToRead < IO_QUEUE_DEPTH; nextToRead++) {
+                    submitRead(static_cast<unsigned>(nextToRead), nextToRead);
+                }
+
+                for (std::uint64_t delivered = 0; delivered < chunkCount;) {
+                    unsigned slot = static_cast<unsigned>(delivered % IO_QUEUE_DEPTH);
+                    while (!ready[slot]) {
+                        ring.Submit(1);
+                        std::uint64_t id;
+                        int result;
+                        while (ring.PopCompletion(id, result)) {
+                            inFlight--;
+                            if (result <= 0) {
+                                errno = result < 0 ? -result : EIO;
+                                throw std::runtime_error("io_uring read " + filename + ": " + std::strerror(errno));
+                            }
+                            IoChunk& chunk = slots[id];
+                            chunk.size += static_cast<std::size_t>(result);
+                            std::size_t expected = chunkSize(slotChunk[id]);
+                            if (chunk.size < expected) {
+                                ring.Prepare(IORING_OP_READ, fd, chunk.data.get() + chunk.size,
+                                             static_cast<unsigned>(expected - chunk.size), chunk.offset + chunk.size, id);
+                                inFlight++;
+                            } else {
+                                ready[id] = true;
+                            }
+                        }
+                    }
+
+                    consumer(static_cast<const char*>(slots[slot].data.get()), slots[slot].size);
+                    delivered++;
+                    if (nextToRead < chunkCount) {
+                        submitRead(slot, nextToRead++);
+                    }
+                }
+            } catch (...) {
+                // Ядро пишет в slots, пока чтения в полёте: дожидаемся их до выхода из области видимости
+                ring.Drain(inFlight);
+                throw;
+            }
         } else {
-            storage = std::make_shared<LinkedListSequence<T>>();
+            // Читающий поток заполняет свободные слоты, вызывающий разбирает заполненные
+            BlockingQueue<int> freeSlots;
+            BlockingQueue<int> filledSlots;
+            for (int i = 0; i < static_cast<int>(IO_QUEUE_DEPTH); i++) {
+                freeSlots.Enqueue(i);
+            }
+            std::atomic<int> failedErrno{0};
+            std::atomic<bool> cancelled{false};
+            std::thread reader([&]() {
+                for (std::uint64_t index = 0; index < chunkCount; index++) {
+                    // Потребитель упал и закрыл freeSlots — выходим без исключения из потока
+                    int slot;
+                    while (!freeSlots.Dequeue(slot, std::chrono::milliseconds(100))) {
+                        if (freeSlots.IsClosed()) return;
+                    }
+                    if (cancelled.load()) return;
+                    IoChunk& chunk = slots[slot];
+                    chunk.offset = index * IoChunk::CAPACITY;
+                    chunk.size = 0;
+                    std::size_t expected = chunkSize(index);
+                    while (chunk.size < expected) {
+                        ssize_t got = pread(fd, chunk.data.get() + chunk.size, expected - chunk.size,
+                                            static_cast<off_t>(chunk.offset + chunk.size));
+                        if (got < 0 && errno == EINTR) continue;
+                        if (got <= 0) {
+                            failedErrno = got < 0 ? errno : EIO;
+                            filledSlots.Close();
+                            return;
+                        }
+                        chunk.size += static_cast<std::size_t>(got);
+                    }
+                    filledSlots.Enqueue(slot);
+                }
+            });
+
+            try {
+                for (std::uint64_t delivered = 0; delivered < chunkCount; delivered++) {
+                    int slot = filledSlots.Dequeue();
+                    consumer(static_cast<const char*>(slots[slot].data.get()), slots[slot].size);
+                    freeSlots.Enqueue(slot);
+                }
+            } catch (...) {
+                cancelled = true;
+                freeSlots.Close();
+                reader.join();
+                if (failedErrno.load() != 0) {
+                    errno = failedErrno.load();
+                    throw std::runtime_error("pread " + filename + ": " + std::strerror(errno));
+                }
+                throw;
+            }
+            reader.join();
         }
+    } catch (...) {
+        close(fd);
+        throw;
     }
+    close(fd);
+}
 
-    Queue(std::initializer_list<T> init, StorageType type = ARRAY) {
-        if (type == ARRAY) {
-            storage = std::make_shared<ArraySequence<T>>(init);
+// Потоковый разбор снимка: куски подаются по мере чтения через Feed
+template <typename T>
+class SnapshotStreamDecoder {
+private:
+    enum State { HEADER, OFFSETS, ITEMS, DONE };
+
+    Sequence<T>& out;
+    State state = HEADER;
+    SnapshotHeader header{};
+    std::vector<std::uint64_t> offsets;
+    std::uint64_t decoded = 0;
+    std::string buffer;
+
+    // Разбирает, сколько получится, начиная с pos; false — нужны ещё данные
+    bool Step(std::size_t& pos) {
+        std::size_t available = buffer.size() - pos;
+        const char* cursor = buffer.data() + pos;
+
+        switch (state) {
+            case HEADER: {
+                if (available < sizeof(header)) return false;
+                std::memcpy(&header, cursor, sizeof(header));
+                bool raw = std::is_trivially_copyable_v<T>;
+                if (std::memcmp(header.magic, "LB3S", 4) != 0 || header.version != SNAPSHOT_VERSION ||
+                    (raw && header.elementSize != sizeof(T)) || header.layout != (raw ? SNAPSHOT_RAW : SNAPSHOT_OFFSETS)) {
+                    throw std::runtime_error("Snapshot does not hold this element type");
+                }
+                if (!SnapshotCountFits(header, sizeof(T))) throw std::runtime_error("Corrupted snapshot header");
+                pos += sizeof(header);
+                state = header.count == 0 ? DONE : (raw ? ITEMS : OFFSETS);
+                return true;
+            }
+            case OFFSETS: {
+                std::size_t bytes = static_cast<std::size_t>(header.count + 1) * sizeof(std::uint64_t);
+                if (available < bytes) return false;
+                offsets.resize(header.count + 1);
+                std::memcpy(offsets.data(), cursor, bytes);
+                pos += bytes;
+                state = ITEMS;
+                return true;
+            }
+            case ITEMS: {
+                const char* end = buffer.data() + buffer.size();
+                std::uint64_t before = decoded;
+                while (decoded < header.count) {
+                    std::size_t itemBytes = sizeof(T);
+                    if constexpr (!std::is_trivially_copyable_v<T>) {
+                        itemBytes = static_cast<std::size_t>(offsets[decoded + 1] - offsets[decoded]);
+                    }
+                    if (static_cast<std::size_t>(end - cursor) < itemBytes) break;
+
+                    T item;
+                    if constexpr (std::is_same_v<T, std::string>) {
+                        item.assign(cursor, itemBytes);
+                    } else {
+                        const char* itemCursor = cursor;
+                        if (!BinaryCodec<T>::Read(itemCursor, cursor + itemBytes, item)) {
+                            throw std::runtime_error("Corrupted snapshot item");
+                        }
+                    }
+                    out.Append(item);
+                    cursor += itemBytes;
+                    decoded++;
+                }
+                pos = static_cast<std::size_t>(cursor - buffer.data());
+                if (decoded == header.count) state = DONE;
+                return decoded != before;
+            }
+            case DONE:
+                return false;
+        }
+        return false;
+    }
+
+public:
+    explicit SnapshotStreamDecoder(Sequence<T>& out) : out(out) {}
+
+    void Feed(const char* data, std::size_t size) {
+        buffer.append(data, size);
+        std::size_t pos = 0;
+        while (Step(pos)) {}
+        buffer.erase(0, pos);
+    }
+
+    void Finish() {
+        if (state != DONE || !buffer.empty()) throw std::runtime_error("Truncated snapshot");
+    }
+};
+
+// Заменяет содержимое out снимком; разбор идёт параллельно с чтением следующих кусков
+template <typename T>
+void DeserializeBinaryReadAhead(const std::string& filename, Sequence<T>& out, IoBackend backend = IO_AUTO) {
+    out.Clear();
+    SnapshotStreamDecoder<T> decoder(out);
+    ReadFileAhead(filename, [&](const char* data, std::size_t size) { decoder.Feed(data, size); }, backend);
+    decoder.Finish();
+}
+
+#endif
+
+#if defined(__linux__)
+
+// ==================== ПЕРСИСТЕНТНАЯ ОЧЕРЕДЬ ====================
+
+struct PersistentQueueOptions {
+    std::size_t segmentBytes = 64 * 1024 * 1024;
+    int syncEveryRecords = 1;                     // fsync после каждых N записей (0 — не по счёту)
+    std::chrono::milliseconds syncInterval{0};    // fsync не позже этого срока после первой несинхронизированной записи
+};
+
+// Очередь поверх журнала из сегментов только на дозапись. Имя сегмента — глобальный
+// номер его первой записи, запись — [длина][crc32][данные BinaryCodec<T>].
+// Dequeue сдвигает позицию чтения в файле read.offset, дочитанные сегменты удаляются.
+// При открытии проверяется только хвостовой сегмент: всё после первой битой записи
+// отрезается. Записи копятся в буфере и пишутся одним write + fdatasync (групповая
+// фиксация) по правилам PersistentQueueOptions или явным Commit(). Срок syncInterval
+// соблюдает фоновый поток, даже если новых Enqueue нет; методы защищены мьютексом.
+template <typename T>
+class PersistentQueue {
+private:
+    struct RecordHeader {
+        std::uint32_t length;
+        std::uint32_t crc;
+    };
+
+    struct OffsetRecord {
+        std::uint64_t readIndex;
+        std::uint64_t segment;
+        std::uint64_t offset;
+        std::uint32_t crc;
+    };
+
+    static constexpr std::uint64_t NO_END = ~std::uint64_t(0);
+
+    std::filesystem::path directory;
+    PersistentQueueOptions options;
+    RingBufferSequence<std::uint64_t> segments;
+
+    int writeFd = -1;
+    std::uint64_t tailBase = 0;
+    std::uint64_t tailWrittenBytes = 0;
+    std::uint64_t writeIndex = 0;
+    std::string pending;
+    int pendingRecords = 0;
+    std::chrono::steady_clock::time_point firstPendingTime;
+
+    int readFd = -1;
+    std::uint64_t readSegment = 0;
+    std::uint64_t readSegmentEnd = NO_END;
+    std::uint64_t readOffset = 0;
+    std::uint64_t readIndex = 0;
+    int offsetFd = -1;
+    bool offsetDirty = false;
+
+    mutable std::mutex mutex;
+    std::condition_variable flushWake;
+    std::thread flusher;
+    bool stopping = false;
+    std::exception_ptr flushError;
+
+    static std::runtime_error SystemError(const std::string& what) {
+        return std::runtime_error(what + ": " + std::strerror(errno));
+    }
+
+    std::filesystem::path SegmentPath(std::uint64_t base) const {
+        std::ostringstream name;
+        name << std::setw(20) << std::setfill('0') << base << ".seg";
+        return directory / name.str();
+    }
+
+    int OpenFile(const std::filesystem::path& path, int flags) const {
+        int fd = open(path.c_str(), flags | O_CLOEXEC, 0644);
+        if (fd < 0) throw SystemError("open " + path.string());
+        return fd;
+    }
+
+    void SyncDirectory() const {
+        int fd = OpenFile(directory, O_RDONLY | O_DIRECTORY);
+        fsync(fd);
+        close(fd);
+    }
+
+    void WriteAll(int fd, const char* data, std::size_t size) {
+        while (size > 0) {
+            ssize_t written = write(fd, data, size);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw SystemError("write " + SegmentPath(tailBase).string());
+            }
+            data += written;
+            size -= static_cast<std::size_t>(written);
+        }
+    }
+
+    bool ReadAt(int fd, void* buffer, std::size_t size, std::uint64_t offset) const {
+        char* out = static_cast<char*>(buffer);
+        while (size > 0) {
+            ssize_t got = pread(fd, out, size, static_cast<off_t>(offset));
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                throw SystemError("pread " + SegmentPath(readSegment).string());
+            }
+            if (got == 0) return false;
+            out += got;
+            size -= static_cast<std::size_t>(got);
+            offset += static_cast<std::uint64_t>(got);
+        }
+        return true;
+    }
+
+    // Передать буфер ядру без fsync — нужно, когда чтение догнало запись
+    void WriteOut() {
+        if (pending.empty()) return;
+        WriteAll(writeFd, pending.data(), pending.size());
+        tailWrittenBytes += pending.size();
+        pending.clear();
+    }
+
+    void SaveOffset() {
+        OffsetRecord record{readIndex, readSegment, readOffset, 0};
+        record.crc = Crc32(reinterpret_cast<const char*>(&record), offsetof(OffsetRecord, crc));
+        if (pwrite(offsetFd, &record, sizeof(record), 0) != static_cast<ssize_t>(sizeof(record))) {
+            throw SystemError("pwrite read.offset");
+        }
+        offsetDirty = true;
+    }
+
+    void OpenReadSegment(std::uint64_t base, std::uint64_t offset) {
+        if (readFd >= 0) close(readFd);
+        readFd = OpenFile(SegmentPath(base), O_RDONLY);
+        readSegment = base;
+        readOffset = offset;
+        if (base == tailBase) {
+            readSegmentEnd = NO_END;
         } else {
-            storage = std::make_shared<LinkedListSequence<T>>(init);
+            struct stat info;
+            if (fstat(readFd, &info) != 0) throw SystemError("fstat " + SegmentPath(base).string());
+            readSegmentEnd = static_cast<std::uint64_t>(info.st_size);
         }
     }
 
-    Queue(const Queue<T>& other) {
-        storage = other.storage->GetSubsequence(0, other.GetLength() - 1);
+    // Удаляет дочитанные запечатанные сегменты и переводит чтение на следующий
+    void ReleaseConsumedSegments() {
+        bool released = false;
+        while (readSegment != tailBase && readOffset >= readSegmentEnd) {
+            std::filesystem::remove(SegmentPath(readSegment));
+            segments.RemoveAt(0);
+            OpenReadSegment(segments.GetFirst(), 0);
+            released = true;
+        }
+        if (released) {
+            SaveOffset();
+            SyncDirectory();
+        }
     }
 
-    Queue<T>& operator=(const Queue<T>& other) {
-        if (this != &other) {
-            storage = other.storage->GetSubsequence(0, other.GetLength() - 1);
+    void RollSegment() {
+        CommitLocked();
+        close(writeFd);
+        if (readSegment == tailBase) {
+            readSegmentEnd = tailWrittenBytes;
         }
-        return *this;
+
+        tailBase = writeIndex;
+        tailWrittenBytes = 0;
+        writeFd = OpenFile(SegmentPath(tailBase), O_WRONLY | O_CREAT | O_EXCL | O_APPEND);
+        segments.Append(tailBase);
+        SyncDirectory();
+        ReleaseConsumedSegments();
     }
 
-    // Основные методы очереди
-    void Enqueue(const T& item) {
-        storage->Append(item);
+    // Проверяет записи хвостового сегмента и отрезает всё после последней целой
+    void RecoverTail() {
+        std::filesystem::path path = SegmentPath(tailBase);
+        std::string content;
+        {
+            std::ifstream file(path, std::ios::binary);
+            content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        std::uint64_t validEnd = 0;
+        std::uint64_t records = 0;
+        while (content.size() - validEnd >= sizeof(RecordHeader)) {
+            RecordHeader header;
+            std::memcpy(&header, content.data() + validEnd, sizeof(header));
+            std::uint64_t end = validEnd + sizeof(header) + header.length;
+            if (end > content.size() || Crc32(content.data() + validEnd + sizeof(header), header.length) != header.crc) {
+                break;
+            }
+            validEnd = end;
+            records++;
+        }
+
+        if (validEnd != content.size()) {
+            std::filesystem::resize_file(path, validEnd);
+        }
+        tailWrittenBytes = validEnd;
+        writeIndex = tailBase + records;
     }
 
-    T Dequeue() {
-        if (storage->IsEmpty()) throw std::out_of_range("Queue is empty");
-        T item = storage->GetFirst();
-        storage->RemoveAt(0);
-        return item;
+    void LoadOffset() {
+        OffsetRecord record{};
+        bool valid = pread(offsetFd, &record, sizeof(record), 0) == static_cast<ssize_t>(sizeof(record)) &&
+                     Crc32(reinterpret_cast<const char*>(&record), offsetof(OffsetRecord, crc)) == record.crc &&
+                     record.segment >= segments.GetFirst() && record.segment <= tailBase;
+
+        if (valid && segments.Contains(record.segment)) {
+            readIndex = record.readIndex;
+            OpenReadSegment(record.segment, record.offset);
+        } else {
+            readIndex = segments.GetFirst();
+            OpenReadSegment(segments.GetFirst(), 0);
+        }
+
+        // Позиция за пределами уцелевшего хвоста — после сбоя записи не дошли до диска
+        if (readSegment == tailBase && readOffset > tailWrittenBytes) {
+            readOffset = tailWrittenBytes;
+            readIndex = writeIndex;
+        }
+        ReleaseConsumedSegments();
     }
 
-    T Peek() const {
-        if (storage->IsEmpty()) throw std::out_of_range("Queue is empty");
-        return storage->GetFirst();
+    // Записать накопленные записи и позицию чтения на диск; вызывается под mutex
+    void CommitLocked() {
+        if (flushError) {
+            std::exception_ptr failure = flushError;
+            flushError = nullptr;
+            std::rethrow_exception(failure);
+        }
+        WriteOut();
+        if (pendingRecords > 0) {
+            if (fdatasync(writeFd) != 0) throw SystemError("fdatasync " + SegmentPath(tailBase).string());
+            pendingRecords = 0;
+        }
+        if (offsetDirty) {
+            fdatasync(offsetFd);
+            offsetDirty = false;
+        }
     }
 
-    // Реализация методов Sequence
-    T GetFirst() const override { return storage->GetFirst(); }
-    T GetLast() const override { return storage->GetLast(); }
-    T Get(int index) const override { return storage->Get(index); }
-    std::shared_ptr<Sequence<T>> GetSubsequence(int startIndex, int endIndex) const override {
-        return storage->GetSubsequence(startIndex, endIndex);
+    // Фиксирует записи, пролежавшие в буфере syncInterval; ошибка отдаётся следующему Commit
+    void FlushLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            if (pendingRecords == 0) {
+                flushWake.wait(lock, [&]() { return stopping || pendingRecords > 0; });
+                continue;
+            }
+            std::chrono::steady_clock::time_point deadline = firstPendingTime + options.syncInterval;
+            if (std::chrono::steady_clock::now() < deadline) {
+                flushWake.wait_until(lock, deadline);
+                continue;
+            }
+            try {
+                CommitLocked();
+            } catch (...) {
+                flushError = std::current_exception();
+                pendingRecords = 0;
+            }
+        }
+    }
+
+    void ReadRecord(T& out, bool advance) {
+        if (readIndex >= writeIndex) throw std::out_of_range("Queue is empty");
+        if (readSegment == tailBase && readOffset + sizeof(RecordHeader) > tailWrittenBytes) {
+            WriteOut();
+        }
+
+        RecordHeader header;
+        std::string payload;
+        if (!ReadAt(readFd, &header, sizeof(header), readOffset)) {
+            throw std::runtime_error("Unexpected end of segment " + SegmentPath(readSegment).string());
+        }
+        payload.resize(header.length);
+        if (!ReadAt(readFd, payload.data(), header.length, readOffset + sizeof(header)) ||
+            Crc32(payload.data(), payload.size()) != header.crc) {
+            throw std::runtime_error("Corrupted record in " + SegmentPath(readSegment).string());
+        }
+
+        const char* cursor = payload.data();
+        if (!BinaryCodec<T>::Read(cursor, payload.data() + payload.size(), out)) {
+            throw std::runtime_error("Malformed record in " + SegmentPath(readSegment).string());
+        }
+
+        if (advance) {
+            readOffset += sizeof(header) + header.length;
+            readIndex++;
+            SaveOffset();
+            ReleaseConsumedSegments();
+        }
     }
-    int GetLength() const override { return storage->GetLength(); }
 
-    void Append(const T& item) override { Enqueue(item); }
-    void Prepend(const T& item) override { storage->Prepend(item); }
-    void InsertAt(const T& item, int index) override { storage->InsertAt(item, index); }
-    void RemoveAt(int index) override { storage->RemoveAt(index); }
-    void Remove(const T& item) override { storage->Remove(item); }
-    void Clear() override { storage->Clear(); }
+public:
+    explicit PersistentQueue(const std::string& path, PersistentQueueOptions options = PersistentQueueOptions())
+        : directory(path), options(options) {
+        std::filesystem::create_directories(directory);
+
+        std::vector<std::uint64_t> bases;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.path().extension() == ".seg") {
+                bases.push_back(std::stoull(entry.path().stem().string()));
+            }
+        }
+        std::sort(bases.begin(), bases.end());
+        for (std::uint64_t base : bases) {
+            segments.Append(base);
+        }
 
-    std::shared_ptr<Sequence<T>> Concat(const Sequence<T>& other) const override {
-        return storage->Concat(other);
-    }
+        if (segments.IsEmpty()) {
+            segments.Append(0);
+            close(OpenFile(SegmentPath(0), O_WRONLY | O_CREAT));
+            SyncDirectory();
+        }
+        tailBase = segments.GetLast();
+        RecoverTail();
+        writeFd = OpenFile(SegmentPath(tailBase), O_WRONLY | O_APPEND);
 
-    std::shared_ptr<Sequence<T>> Map(std::function<T(T)> func) const override {
-        return storage->Map(func);
-    }
+        offsetFd = OpenFile(directory / "read.offset", O_RDWR | O_CREAT);
+        LoadOffset();
 
-    std::shared_ptr<Sequence<T>> Where(std::function<bool(T)> predicate) const override {
-        return storage->Where(predicate);
+        if (options.syncInterval.count() > 0) {
+            flusher = std::thread([this]() { FlushLoop(); });
+        }
     }
 
-    T Reduce(std::function<T(T, T)> func, T initial) const override {
-        return storage->Reduce(func, initial);
+    ~PersistentQueue() {
+        if (flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            flushWake.notify_one();
+            flusher.join();
+        }
+        try {
+            Commit();
+        } catch (...) {
+        }
+        close(writeFd);
+        close(readFd);
+        close(offsetFd);
     }
 
-    std::shared_ptr<Sequence<T>> Zip(const Sequence<T>& other) const override {
-        return storage->Zip(other);
-    }
+    PersistentQueue(const PersistentQueue<T>&) = delete;
+    PersistentQueue<T>& operator=(const PersistentQueue<T>&) = delete;
 
-    std::pair<std::shared_ptr<Sequence<T>>, std::shared_ptr<Sequence<T>>> Split(std::function<bool(T)> predicate) const override {
-        return storage->Split(predicate);
-    }
+    void Enqueue(const T& item) {
+        std::string payload;
+        BinaryCodec<T>::Write(payload, item);
+        RecordHeader header{static_cast<std::uint32_t>(payload.size()), Crc32(payload.data(), payload.size())};
+
+        std::unique_lock<std::mutex> lock(mutex);
+        std::uint64_t segmentSize = tailWrittenBytes + pending.size();
+        if (segmentSize > 0 && segmentSize + sizeof(header) + payload.size() > options.segmentBytes) {
+            RollSegment();
+        }
 
-    std::shared_ptr<Sequence<T>> Slice(int start, int end) const override {
-        return storage->Slice(start, end);
+        bool wakeFlusher = pendingRecords == 0;
+        if (wakeFlusher) {
+            firstPendingTime = std::chrono::steady_clock::now();
+        }
+        pending.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        pending.append(payload);
+        pendingRecords++;
+        writeIndex++;
+
+        bool byCount = options.syncEveryRecords > 0 && pendingRecords >= options.syncEveryRecords;
+        bool byTime = options.syncInterval.count() > 0 &&
+                      std::chrono::steady_clock::now() - firstPendingTime >= options.syncInterval;
+        if (byCount || byTime) {
+            CommitLocked();
+        } else if (wakeFlusher && flusher.joinable()) {
+            lock.unlock();
+            flushWake.notify_one();
+        }
     }
 
-    bool ContainsSubsequence(const Sequence<T>& subsequence) const override {
-        return storage->ContainsSubsequence(subsequence);
+    T Dequeue() {
+        std::lock_guard<std::mutex> lock(mutex);
+        T item;
+        ReadRecord(item, true);
+        return item;
     }
 
-    T& operator[](int index) override { return (*storage)[index]; }
-    const T& operator[](int index) const override { return (*storage)[index]; }
-
-    bool Contains(const T& item) const override { return storage->Contains(item); }
-    int IndexOf(const T& item) const override { return storage->IndexOf(item); }
-    bool IsEmpty() const override { return storage->IsEmpty(); }
+    T Peek() {
+        std::lock_guard<std::mutex> lock(mutex);
+        T item;
+        ReadRecord(item, false);
+        return item;
+    }
 
-    std::string ToString() const override {
-        return storage->ToString();
+    void Commit() {
+        std::lock_guard<std::mutex> lock(mutex);
+        CommitLocked();
     }
 
-    // Специфичные методы для очереди
-    std::shared_ptr<Queue<T>> Filter(std::function<bool(T)> predicate) const {
-        auto result = std::make_shared<Queue<T>>();
-        for (int i = 0; i < GetLength(); i++) {
-            T item = Get(i);
-            if (predicate(item)) {
-                result->Enqueue(item);
-            }
-        }
-        return result;
+    int GetLength() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return static_cast<int>(writeIndex - readIndex);
     }
 
-    void Serialize(const std::string& filename) const {
-        std::ofstream file(filename);
-        for (int i = 0; i < GetLength(); i++) {
-            file << Get(i) << "\n";
-        }
+    bool IsEmpty() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return writeIndex == readIndex;
     }
 
-    void Deserialize(const std::string& filename) {
-        std::ifstream file(filename);
-        T item;
-        while (file >> item) {
-            Enqueue(item);
-        }
+    int GetSegmentCount() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return segments.GetLength();
     }
 };
 
+#endif
+
 // ==================== ТЕСТЫ ====================
 
 class TestRunner {
@@ -965,17 +6626,114 @@ private:
         }
     }
 
+    // Считает конструирования и копии, чтобы проверять работу с сырой памятью
+    struct LifetimeCounter {
+        static inline int constructed = 0;
+        static inline int copies = 0;
+        static inline int alive = 0;
+
+        std::string value;
+
+        LifetimeCounter() { constructed++; alive++; }
+        LifetimeCounter(std::string text) : value(std::move(text)) { constructed++; alive++; }
+        LifetimeCounter(const LifetimeCounter& other) : value(other.value) { constructed++; copies++; alive++; }
+        LifetimeCounter(LifetimeCounter&& other) noexcept : value(std::move(other.value)) { constructed++; alive++; }
+        LifetimeCounter& operator=(const LifetimeCounter& other) { value = other.value; copies++; return *this; }
+        LifetimeCounter& operator=(LifetimeCounter&& other) noexcept { value = std::move(other.value); return *this; }
+        ~LifetimeCounter() { alive--; }
+
+        static void Reset() { constructed = copies = 0; }
+
+        bool operator==(const LifetimeCounter& other) const { return value == other.value; }
+        bool operator!=(const LifetimeCounter& other) const { return value != other.value; }
+        friend std::ostream& operator<<(std::ostream& os, const LifetimeCounter& item) { return os << item.value; }
+    };
+
+    // Обёртка с пользовательским копированием: отключает побайтовый перенос для сравнения
+    template <typename T>
+    struct OpaqueValue {
+        T value;
+
+        OpaqueValue() : value() {}
+        OpaqueValue(T item) : value(item) {}
+        OpaqueValue(const OpaqueValue& other) : value(other.value) {}
+        OpaqueValue& operator=(const OpaqueValue& other) { value = other.value; return *this; }
+
+        bool operator==(const OpaqueValue& other) const { return value == other.value; }
+        bool operator!=(const OpaqueValue& other) const { return value != other.value; }
+        friend std::ostream& operator<<(std::ostream& os, const OpaqueValue& item) { return os << item.value; }
+    };
+
 public:
     void runAllTests() {
         std::cout << "=== ЗАПУСК ВСЕХ ТЕСТОВ ===" << std::endl;
         
         testArraySequenceBasic();
+        testArraySequenceStorage();
+        testSmallArraySequence();
         testLinkedListSequenceBasic();
         testQueueOperations();
+        testRingBuffer();
+        testRangeOperations();
+        testDoubleEndedArray();
+        testPriorityQueue();
+        testDelayedQueue();
+        testSlidingWindow();
+        testAdaptiveQueue();
+        testStaticQueue();
+        testSpillQueue();
+#if LB3_QUEUE_METRICS
+        testQueueMetrics();
+#endif
+        testSpscQueue();
+        testMpmcQueue();
+        testBroadcastQueue();
+        testBlockingQueue();
+        testPipeline();
+        testWorkStealingPool();
+#if defined(__cpp_impl_coroutine)
+        testAsyncQueue();
+#endif
+#if defined(__linux__)
+        testSharedMemoryQueue();
+        testPersistentQueue();
+        testBinarySnapshot();
+        testAsyncSerialization();
+        testMappedArrayGrowth();
+#endif
         testFunctionalOperations();
         testEdgeCases();
         testComplexTypes();
         testPerformance();
+        testArrayStoragePerformance();
+        testSmallArrayPerformance();
+        testTrivialRelocationPerformance();
+        testRangePerformance();
+        testDoubleEndedPerformance();
+        testPriorityPerformance();
+        testDelayedPerformance();
+        testSlidingWindowPerformance();
+        testAdaptivePerformance();
+        testStaticDispatchPerformance();
+        testSpillPerformance();
+#if LB3_QUEUE_METRICS
+        testMetricsPerformance();
+#endif
+        testSpscPerformance();
+        testMpmcPerformance();
+        testBroadcastPerformance();
+        testPipelinePerformance();
+        testPoolPerformance();
+#if defined(__cpp_impl_coroutine)
+        testCoroutinePerformance();
+#endif
+#if defined(__linux__)
+        testSharedMemoryPerformance();
+        testPersistentPerformance();
+        testSnapshotPerformance();
+        testAsyncSerializationPerformance();
+        testMappedGrowthPerformance();
+#endif
         
         printResults();
     }
@@ -1007,6 +6765,101 @@ public:
         assertEqual(sub->Get(0), 1, "Подпоследовательность элемент 0");
     }
 
+    void testArraySequenceStorage() {
+        std::cout << "\n--- Тестирование ArraySequence (сырой буфер) ---" << std::endl;
+
+        LifetimeCounter::Reset();
+        {
+            ArraySequence<LifetimeCounter> seq(1000);
+            assertEqual(LifetimeCounter::constructed, 0, "Ёмкость без конструирования элементов");
+
+            LifetimeCounter item("a");
+            seq.Append(std::move(item));
+            seq.Emplace("b");
+            seq.Append(LifetimeCounter("c"));
+            assertEqual(LifetimeCounter::copies, 0, "Append(T&&) и Emplace без копий");
+
+            seq.Emplace(seq[0]);
+            seq.InsertAt(seq[2], 1);
+            assertEqual(seq.ToString(), "[a, c, b, c, a]", "Вставка ссылки на собственный элемент");
+            seq.RemoveAt(0);
+            assertEqual(LifetimeCounter::alive, 5, "RemoveAt разрушает освободившуюся ячейку");
+
+            seq.ShrinkToFit();
+            assertEqual(seq.GetCapacity(), 4, "ShrinkToFit");
+            seq.Emplace(seq[3]);
+            assertEqual(seq.ToString(), "[c, b, c, a, a]", "Emplace собственного элемента при росте");
+
+            ArraySequence<LifetimeCounter> moved(std::move(seq));
+            assertTrue(seq.IsEmpty() && moved.GetLength() == 5, "Перемещающий конструктор");
+            seq = std::move(moved);
+            assertTrue(moved.IsEmpty() && seq.GetLast().value == "a", "Перемещающее присваивание");
+
+            ArraySequence<LifetimeCounter> copy;
+            copy = seq;
+            copy.Clear();
+            assertTrue(copy.IsEmpty() && seq.GetLength() == 5, "Копия независима");
+            seq.Reserve(100);
+            assertTrue(seq.GetCapacity() == 100 && seq.Get(1).value == "b", "Reserve сохраняет элементы");
+        }
+        assertEqual(LifetimeCounter::alive, 0, "Все элементы разрушены");
+
+        ArraySequence<int> empty(0);
+        empty.Append(7);
+        assertEqual(empty.GetFirst(), 7, "Рост из нулевой ёмкости");
+
+        // Тривиально копируемые элементы: realloc при росте, memmove при сдвигах
+        ArraySequence<Complex> complexSeq;
+        for (int i = 0; i < 100; i++) complexSeq.Append(Complex(i, -i));
+        complexSeq.InsertAt(complexSeq[99], 0);
+        complexSeq.RemoveAt(50);
+        assertTrue(complexSeq.GetLength() == 100 && complexSeq.GetFirst() == Complex(99, -99) &&
+                   complexSeq.Get(50) == Complex(50, -50) && complexSeq.GetLast() == Complex(99, -99), "Complex сдвиги memmove");
+        SmallArraySequence<PersonID, 2> ids;
+        for (int i = 0; i < 9; i++) ids.Prepend(PersonID{i, i * 10});
+        while (ids.GetLength() > 2) ids.RemoveAt(1);
+        ids.ShrinkToFit();
+        assertTrue(ids.IsInline() && ids.GetFirst() == PersonID{8, 80} && ids.GetLast() == PersonID{0, 0}, "PersonID realloc и встроенный буфер");
+    }
+
+    void testSmallArraySequence() {
+        std::cout << "\n--- Тестирование SmallArraySequence ---" << std::endl;
+
+        LifetimeCounter::Reset();
+        {
+            SmallArraySequence<LifetimeCounter, 4> seq;
+            assertTrue(seq.IsInline() && seq.GetCapacity() == 4, "Пустая последовательность во встроенном буфере");
+            assertEqual(LifetimeCounter::constructed, 0, "Встроенный буфер не конструирует элементы");
+
+            for (const char* text : {"a", "b", "c", "d"}) seq.Emplace(text);
+            assertTrue(seq.IsInline(), "Четыре элемента без кучи");
+            seq.Emplace("e");
+            assertTrue(!seq.IsInline() && seq.GetCapacity() == 8, "Переполнение переносит в кучу");
+            assertEqual(seq.ToString(), "[a, b, c, d, e]", "Порядок после переноса в кучу");
+
+            seq.RemoveAt(0);
+            seq.RemoveAt(0);
+            seq.ShrinkToFit();
+            assertTrue(seq.IsInline() && seq.Get(2).value == "e", "ShrinkToFit возвращает во встроенный буфер");
+
+            SmallArraySequence<LifetimeCounter, 4> moved(std::move(seq));
+            assertTrue(moved.IsInline() && moved.GetLength() == 3 && seq.IsEmpty(), "Перемещение встроенного буфера");
+            SmallArraySequence<LifetimeCounter, 4> copy(moved);
+            copy.Prepend(LifetimeCounter("z"));
+            copy.Append(LifetimeCounter("y"));
+            moved = std::move(copy);
+            assertTrue(!moved.IsInline() && moved.GetFirst().value == "z" && copy.IsEmpty(), "Перемещение буфера из кучи");
+        }
+        assertEqual(LifetimeCounter::alive, 0, "Все элементы разрушены");
+
+        SmallArraySequence<int> small{1, 2, 3, 4, 5};
+        const Sequence<int>& base = small;
+        assertEqual(base.Map([](int x) { return x * x; })->ToString(), "[1, 4, 9, 16, 25]", "Map через Sequence<T>");
+        assertEqual(base.Where([](int x) { return x % 2 == 1; })->GetLength(), 3, "Where через Sequence<T>");
+        assertEqual(base.Reduce([](int a, int b) { return a + b; }, 0), 15, "Reduce через Sequence<T>");
+        assertTrue(base.Concat(small)->GetLength() == 10 && small.IsInline(), "Concat через Sequence<T>");
+    }
+
     void testLinkedListSequenceBasic() {
         std::cout << "\n--- Тестирование LinkedListSequence (базовое) ---" << std::endl;
         
@@ -1028,6 +6881,14 @@ public:
         
         seq.RemoveAt(2);
         assertEqual(seq.Get(2), 2, "Удаление по индексу");
+
+        LinkedListSequence<LifetimeCounter> counters;
+        counters.Append(LifetimeCounter("x"));
+        counters.Append(LifetimeCounter("y"));
+        int copiesBefore = LifetimeCounter::copies;
+        std::string visited;
+        counters.ForEach([&visited](const LifetimeCounter& item) { visited += item.value; });
+        assertTrue(visited == "xy" && LifetimeCounter::copies == copiesBefore, "ForEach по узлам без копий");
     }
 
     void testQueueOperations() {
@@ -1057,6 +6918,1264 @@ public:
         assertEqual(listQueue.GetLength(), 1, "List queue length");
     }
 
+    void testRingBuffer() {
+        std::cout << "\n--- Тестирование RingBufferSequence ---" << std::endl;
+
+        RingBufferSequence<int> ring(4);
+        for (int i = 1; i <= 4; i++) {
+            ring.Append(i);
+        }
+        ring.RemoveAt(0);
+        ring.RemoveAt(0);
+        ring.Append(5);
+        ring.Append(6);
+        assertEqual(ring.GetCapacity(), 4, "Кольцо без перевыделения");
+        assertEqual(ring.Get(2), 5, "Get через границу буфера");
+        assertEqual(ring[3], 6, "operator[] через границу буфера");
+        assertEqual(ring.ToString(), "[3, 4, 5, 6]", "Порядок после переноса");
+
+        ring.Append(7);
+        assertEqual(ring.GetCapacity(), 8, "Рост кольца");
+        assertEqual(ring.ToString(), "[3, 4, 5, 6, 7]", "Порядок после роста");
+
+        ring.Prepend(2);
+        assertEqual(ring.GetFirst(), 2, "Prepend в кольцо");
+        ring.InsertAt(10, 1);
+        ring.InsertAt(20, 5);
+        assertEqual(ring.ToString(), "[2, 10, 3, 4, 5, 20, 6, 7]", "Вставка в середину кольца");
+        ring.RemoveAt(1);
+        ring.RemoveAt(4);
+        assertEqual(ring.ToString(), "[2, 3, 4, 5, 6, 7]", "Удаление из середины кольца");
+
+        Queue<std::string> queue(Queue<std::string>::RING);
+        for (int i = 0; i < 100; i++) {
+            queue.Enqueue(std::to_string(i));
+            if (i % 2 == 1) queue.Dequeue();
+        }
+        assertEqual(queue.GetLength(), 50, "Ring queue length");
+        assertEqual(queue.Peek(), "50", "Ring queue Peek");
+        assertEqual(queue.Get(49), "99", "Ring queue Get");
+
+        Queue<int> initQueue({1, 2, 3}, Queue<int>::RING);
+        assertEqual(initQueue.Dequeue(), 1, "Ring queue Dequeue");
+        assertEqual(initQueue.Reduce([](int a, int b) { return a + b; }, 0), 5, "Ring queue Reduce");
+    }
+
+    void testRangeOperations() {
+        std::cout << "\n--- Тестирование групповых операций ---" << std::endl;
+
+        const int items[] = {100, 101, 102};
+        auto check = [&](Sequence<int>& seq, const std::string& name) {
+            for (int i = 0; i < 8; i++) seq.Append(i);
+            seq.InsertRange(3, items, items + 3);
+            seq.InsertRange(0, items, items + 1);
+            seq.AppendRange(items + 1, items + 3);
+            assertEqual(seq.ToString(), "[100, 0, 1, 2, 100, 101, 102, 3, 4, 5, 6, 7, 101, 102]", name + " InsertRange/AppendRange");
+            seq.RemoveRange(4, 3);
+            seq.RemoveRange(0, 2);
+            seq.RemoveRange(seq.GetLength() - 2, 2);
+            seq.RemoveRange(1, 0);
+            assertEqual(seq.ToString(), "[1, 2, 3, 4, 5, 6, 7]", name + " RemoveRange");
+            assertException([&]() { seq.InsertRange(8, items, items + 1); }, name + " InsertRange за концом");
+            assertException([&]() { seq.RemoveRange(5, 3); }, name + " RemoveRange за концом");
+        };
+
+        ArraySequence<int> array;
+        check(array, "Array");
+        LinkedListSequence<int> list;
+        check(list, "List");
+        RingBufferSequence<int> ring;
+        ring.Append(-1);
+        ring.Prepend(-2);
+        ring.RemoveRange(0, 2);
+        check(ring, "Ring");
+        Queue<int> queue(Queue<int>::LINKED_LIST);
+        check(queue, "Queue");
+
+        // Диапазон из самой последовательности
+        array.InsertRange(2, array.Data(), array.Data() + array.GetLength());
+        assertEqual(array.ToString(), "[1, 2, 1, 2, 3, 4, 5, 6, 7, 3, 4, 5, 6, 7]", "Array InsertRange из себя");
+
+        // Нетривиальные элементы: хвост длиннее и короче диапазона
+        const std::string words[] = {"x", "y", "z"};
+        ArraySequence<std::string> strings{"a", "b", "c", "d", "e"};
+        strings.InsertRange(1, words, words + 3);
+        strings.InsertRange(7, words, words + 3);
+        strings.RemoveRange(2, 3);
+        assertEqual(strings.ToString(), "[a, x, c, d, x, y, z, e]", "String InsertRange/RemoveRange");
+
+        HeapSequence<int> heap{5, 1, 4};
+        const int many[] = {9, 3, 7, 2, 8, 6};
+        heap.InsertRange(0, many, many + 6);
+        heap.RemoveRange(heap.GetLength() - 2, 2);
+        heap.RemoveRange(1, 2);
+        std::string drained;
+        while (!heap.IsEmpty()) {
+            drained += std::to_string(heap.GetFirst());
+            heap.RemoveAt(0);
+        }
+        assertEqual(drained.size(), static_cast<size_t>(5), "Heap RemoveRange длина");
+        assertTrue(std::is_sorted(drained.begin(), drained.end()) && drained[0] == '1', "Heap порядок после диапазонов");
+
+#if LB3_QUEUE_METRICS
+        Queue<int> measured(Queue<int>::RING);
+        measured.EnableMetrics();
+        measured.AppendRange(many, many + 6);
+        measured.RemoveRange(1, 2);
+        measured.Dequeue();
+        assertTrue(measured.GetMetrics().depth == 3 && measured.GetMetrics().count == 1, "Метрики после групповых операций");
+#endif
+
+        Queue<int, RingStorage> staticQueue;
+        staticQueue.AppendRange(many, many + 6);
+        staticQueue.RemoveRange(0, 4);
+        assertEqual(staticQueue.Dequeue(), 8, "Статическая очередь RemoveRange");
+    }
+
+    void testDoubleEndedArray() {
+        std::cout << "\n--- Тестирование DoubleEndedArraySequence ---" << std::endl;
+
+        DoubleEndedArraySequence<int> seq;
+        for (int i = 0; i < 1000; i++) {
+            seq.Prepend(i);
+            seq.Append(-i);
+        }
+        assertTrue(seq.GetLength() == 2000 && seq.GetFirst() == 999 && seq.GetLast() == -999, "Prepend и Append");
+        assertTrue(seq.Get(999) == 0 && seq.Get(1000) == 0 && seq[1001] == -1, "Порядок по индексу");
+        assertTrue(seq.GetCapacity() <= 8192, "Ёмкость растёт геометрически");
+
+        seq.RemoveAt(0);
+        seq.RemoveAt(seq.GetLength() - 1);
+        seq.InsertAt(7, 1);
+        seq.InsertAt(8, seq.GetLength() - 1);
+        assertTrue(seq.GetFirst() == 998 && seq.Get(1) == 7 && seq.Get(seq.GetLength() - 2) == 8 && seq.GetLast() == -998,
+                   "InsertAt и RemoveAt у обоих краёв");
+        assertEqual(seq.Reduce([](int a, int b) { return a + b; }, 0), 15, "Reduce после правок");
+
+        // Очередь поверх массива: начало уходит вправо, но память не растёт
+        DoubleEndedArraySequence<int> window;
+        for (int i = 0; i < 100000; i++) {
+            window.Append(i);
+            if (window.GetLength() > 10) window.RemoveAt(0);
+        }
+        assertTrue(window.GetFirst() == 99990 && window.GetCapacity() <= 64, "Скользящая очередь без роста памяти");
+
+        DoubleEndedArraySequence<int> reserved(16);
+        reserved.Prepend(1);
+        reserved.Prepend(0);
+        assertTrue(reserved.GetCapacity() == 16 && reserved.ToString() == "[0, 1]", "Prepend в зарезервированный буфер");
+
+        LifetimeCounter::Reset();
+        {
+            DoubleEndedArraySequence<LifetimeCounter> names{LifetimeCounter("c"), LifetimeCounter("d")};
+            names.Prepend(LifetimeCounter("b"));
+            names.Prepend(LifetimeCounter("a"));
+            const LifetimeCounter middle[] = {LifetimeCounter("x"), LifetimeCounter("y"), LifetimeCounter("z")};
+            names.InsertRange(1, middle, middle + 3);
+            names.InsertRange(6, middle, middle + 1);
+            names.InsertRange(0, names.Data() + 6, names.Data() + 8);
+            names.RemoveRange(3, 2);
+            assertEqual(names.ToString(), "[x, d, a, z, b, c, x, d]", "Диапазоны с нетривиальными элементами");
+
+            DoubleEndedArraySequence<LifetimeCounter> moved(std::move(names));
+            DoubleEndedArraySequence<LifetimeCounter> copy;
+            copy = moved;
+            assertTrue(names.IsEmpty() && copy.GetLength() == 8 && copy.GetLast().value == "d", "Копирование и перемещение");
+        }
+        assertEqual(LifetimeCounter::alive, 0, "Все элементы разрушены");
+
+        const Sequence<int>& base = reserved;
+        assertEqual(base.Map([](int x) { return x + 10; })->ToString(), "[10, 11]", "Map через Sequence<T>");
+        assertException([&]() { seq.RemoveAt(seq.GetLength()); }, "RemoveAt за концом");
+
+        Queue<int, DoubleEndedStorage> queue{1, 2, 3};
+        queue.Enqueue(4);
+        assertEqual(queue.Dequeue() + queue.Dequeue(), 3, "Очередь на двустороннем массиве");
+    }
+
+    void testPriorityQueue() {
+        std::cout << "\n--- Тестирование приоритетных очередей ---" << std::endl;
+
+        Queue<int> minQueue(Queue<int>::PRIORITY);
+        for (int value : {5, 1, 9, 3, 7, 3, 0, 8}) {
+            minQueue.Enqueue(value);
+        }
+        assertEqual(minQueue.Peek(), 0, "PRIORITY Peek наименьший");
+        std::string order;
+        while (!minQueue.IsEmpty()) {
+            order += std::to_string(minQueue.Dequeue());
+        }
+        assertEqual(order, std::string("01335789"), "PRIORITY порядок извлечения");
+
+        Queue<int> maxQueue([](const int& a, const int& b) { return a > b; });
+        for (int i = 0; i < 1000; i++) {
+            maxQueue.Enqueue((i * 7919) % 1000);
+        }
+        maxQueue.Remove(999);
+        bool sorted = true;
+        int previous = maxQueue.Dequeue();
+        assertEqual(previous, 998, "Компаратор и Remove вершины");
+        while (!maxQueue.IsEmpty()) {
+            int current = maxQueue.Dequeue();
+            if (current > previous) sorted = false;
+            previous = current;
+        }
+        assertTrue(sorted, "Компаратор по убыванию");
+
+        Queue<Complex> complexQueue({Complex(3, 4), Complex(1, 0), Complex(0, 2)}, Queue<Complex>::PRIORITY);
+        Queue<Complex> complexCopy(complexQueue);
+        complexQueue.Dequeue();
+        assertEqual(complexCopy.Dequeue(), Complex(1, 0), "Копия сохраняет порядок кучи");
+        auto filtered = complexCopy.Where([](Complex c) { return std::abs(c) > 1; });
+        assertEqual(filtered->GetFirst(), Complex(0, 2), "Where перестраивает кучу");
+
+        PairingHeap<int> deadlines;
+        PairingHeap<int>::Handle late = deadlines.Enqueue(50);
+        deadlines.Enqueue(20);
+        PairingHeap<int>::Handle middle = deadlines.Enqueue(40);
+        deadlines.Enqueue(30);
+        deadlines.DecreaseKey(late, 10);
+        assertEqual(deadlines.Peek(), 10, "DecreaseKey поднимает к вершине");
+        deadlines.DecreaseKey(middle, 25);
+        deadlines.Dequeue();
+        deadlines.Dequeue();
+        assertEqual(deadlines.Dequeue(), 25, "DecreaseKey внутри поддерева");
+        assertException([&]() { deadlines.DecreaseKey(deadlines.Enqueue(5), 60); }, "DecreaseKey с понижением");
+
+        PairingHeap<int> randomHeap;
+        std::vector<PairingHeap<int>::Handle> handles;
+        for (int i = 0; i < 2000; i++) {
+            handles.push_back(randomHeap.Enqueue(10000 + (i * 7919) % 2000));
+        }
+        for (int i = 0; i < 2000; i += 3) {
+            randomHeap.DecreaseKey(handles[i], randomHeap.Get(handles[i]) - 5000);
+        }
+        sorted = true;
+        previous = randomHeap.Dequeue();
+        while (!randomHeap.IsEmpty()) {
+            int current = randomHeap.Dequeue();
+            if (current < previous) sorted = false;
+            previous = current;
+        }
+        assertTrue(sorted, "Парная куча после DecreaseKey");
+    }
+
+    void testDelayedQueue() {
+        std::cout << "\n--- Тестирование DelayedQueue ---" << std::endl;
+
+        using namespace std::chrono;
+        auto start = DelayedQueue<int>::Clock::now() + hours(1);
+        DelayedQueue<int> queue(milliseconds(1), start);
+
+        queue.EnqueueAt(3, start + milliseconds(300000));
+        queue.EnqueueAt(2, start + milliseconds(5000));
+        queue.EnqueueAt(1, start + milliseconds(10));
+        DelayedQueue<int>::Handle cancelled = queue.EnqueueAt(99, start + milliseconds(70));
+        queue.Enqueue(0);
+        assertEqual(queue.GetLength(), 1, "Без задержки виден сразу");
+        assertEqual(queue.GetPendingCount(), 4, "Ожидающие таймеры");
+
+        assertTrue(queue.Cancel(cancelled), "Cancel ожидающего");
+        assertFalse(queue.Cancel(cancelled), "Повторный Cancel");
+        assertEqual(queue.Advance(start + milliseconds(9)), 0, "До срока ничего не истекло");
+        assertEqual(queue.Advance(start + milliseconds(10)), 1, "Истёк уровень 0");
+        assertEqual(queue.Advance(start + milliseconds(4999)), 0, "Раскладка уровня 1 не торопит");
+        assertEqual(queue.Advance(start + milliseconds(5000)), 1, "Истёк уровень 2");
+        assertEqual(queue.Advance(start + milliseconds(300000)), 1, "Истёк уровень 3");
+
+        std::string order;
+        while (!queue.IsEmpty()) {
+            order += std::to_string(queue.Dequeue());
+        }
+        assertEqual(order, std::string("0123"), "Порядок истечения");
+        assertException([&]() { queue.Dequeue(); }, "Dequeue без истёкших");
+
+        // Дальше горизонта колеса (64^4 тиков ≈ 4.6 часа при 1 мс)
+        DelayedQueue<int>::Handle handle = queue.EnqueueAt(7, start + hours(10));
+        queue.Advance(start + hours(9));
+        assertEqual(queue.GetLength(), 0, "Дальний таймер не истёк раньше");
+        queue.Advance(start + hours(10));
+        assertEqual(queue.Dequeue(), 7, "Дальний таймер истёк");
+        assertFalse(queue.Cancel(handle), "Cancel истёкшего");
+
+        DelayedQueue<std::string> realTime;
+        realTime.EnqueueAfter("later", milliseconds(20));
+        std::string item;
+        assertFalse(realTime.TryDequeue(item), "EnqueueAfter не виден сразу");
+        std::this_thread::sleep_for(milliseconds(30));
+        assertTrue(realTime.TryDequeue(item) && item == "later", "EnqueueAfter после задержки");
+    }
+
+    void testSlidingWindow() {
+        std::cout << "\n--- Тестирование SlidingWindowQueue ---" << std::endl;
+
+        SlidingWindowQueue<double> maxima([](const double& a, const double& b) { return std::max(a, b); },
+                                          -std::numeric_limits<double>::infinity(), 3);
+        std::string rolling;
+        for (double value : {5.0, 1.0, 3.0, 2.0, 0.0, 4.0, 1.0}) {
+            maxima.Enqueue(value);
+            rolling += std::to_string(static_cast<int>(maxima.GetAggregate()));
+        }
+        assertEqual(rolling, std::string("5553344"), "Скользящий максимум окна 3");
+        assertEqual(maxima.GetLength(), 3, "Окно ограничено");
+
+        // Некоммутативная свёртка проверяет порядок «старые → новые»
+        SlidingWindowQueue<std::string> concat([](const std::string& a, const std::string& b) { return a + b; }, "");
+        for (std::string part : {"a", "b", "c"}) concat.Enqueue(part);
+        assertEqual(concat.GetAggregate(), std::string("abc"), "Порядок свёртки");
+        assertEqual(concat.Dequeue(), std::string("a"), "Dequeue старейшего");
+        concat.Enqueue("d");
+        assertEqual(concat.GetAggregate(), std::string("bcd"), "Свёртка после переноса стопок");
+        concat.Dequeue();
+        concat.Dequeue();
+        assertEqual(concat.GetAggregate(), std::string("d"), "Свёртка из задней стопки");
+        concat.Dequeue();
+        assertEqual(concat.GetAggregate(), std::string(""), "Пустое окно даёт identity");
+        assertException([&]() { concat.Dequeue(); }, "Dequeue из пустого окна");
+
+        SlidingWindowQueue<int> sums([](const int& a, const int& b) { return a + b; }, 0, 100,
+                                     [](const int& total, const int& x) { return total - x; });
+        SlidingWindowQueue<int> twoStacks([](const int& a, const int& b) { return a + b; }, 0, 100);
+        bool same = true;
+        for (int i = 0; i < 1000; i++) {
+            sums.Enqueue(i);
+            twoStacks.Enqueue(i);
+            if (i % 7 == 0) {
+                sums.Dequeue();
+                twoStacks.Dequeue();
+            }
+            if (sums.GetAggregate() != twoStacks.GetAggregate()) same = false;
+        }
+        assertTrue(sums.IsInvertible() && same, "Обратимый путь совпадает с двумя стопками");
+        assertEqual(sums.GetAggregate(), (900 + 999) * 100 / 2, "Сумма последних 100");
+    }
+
+#if LB3_QUEUE_METRICS
+    void testQueueMetrics() {
+        std::cout << "\n--- Тестирование метрик очереди ---" << std::endl;
+
+        LatencyHistogram histogram;
+        for (std::uint64_t value = 1; value <= 100000; value++) {
+            histogram.Record(value);
+        }
+        std::uint64_t p50 = histogram.Percentile(0.5);
+        std::uint64_t p999 = histogram.Percentile(0.999);
+        assertTrue(p50 >= 50000 && p50 <= 50000 + 50000 / 64, "p50 с точностью 1/64");
+        assertTrue(p999 >= 99900 && p999 <= 100000, "p999 не больше максимума");
+        assertEqual(histogram.Percentile(0.0), static_cast<std::uint64_t>(1), "Малые значения точно");
+
+        LatencyHistogram shared;
+        std::vector<std::thread> writers;
+        for (int t = 0; t < 4; t++) {
+            writers.emplace_back([&shared, t]() {
+                for (int i = 0; i < 10000; i++) shared.Record(static_cast<std::uint64_t>(i * (t + 1)));
+            });
+        }
+        for (auto& writer : writers) writer.join();
+        assertEqual(shared.GetCount(), static_cast<std::uint64_t>(40000), "Запись из нескольких потоков");
+        assertEqual(shared.GetMax(), static_cast<std::uint64_t>(9999 * 4), "Максимум из нескольких потоков");
+
+        Queue<int> queue(Queue<int>::RING);
+        queue.Enqueue(1);
+        queue.EnableMetrics();
+        queue.Enqueue(2);
+        queue.Prepend(0);
+        queue.Enqueue(3);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        queue.Dequeue();
+        queue.Dequeue();
+        queue.RemoveAt(0);
+        QueueMetricsSnapshot snapshot = queue.GetMetrics();
+        assertEqual(snapshot.count, static_cast<std::uint64_t>(2), "Учтены только Dequeue");
+        assertTrue(snapshot.p50 >= 5000000, "Время пребывания не меньше паузы");
+        assertEqual(snapshot.highWater, 4, "Пиковая глубина");
+        assertEqual(snapshot.depth, 1, "Текущая глубина");
+        assertTrue(snapshot.ToJson().find("\"p999_ns\":") != std::string::npos, "JSON содержит p999");
+        assertTrue(snapshot.ToText().find("high_water=4") != std::string::npos, "Текстовый срез");
+
+        Queue<int> priority(Queue<int>::PRIORITY);
+        priority.EnableMetrics();
+        priority.Enqueue(2);
+        priority.Enqueue(1);
+        priority.Dequeue();
+        assertTrue(priority.GetMetrics().count == 0 && priority.GetMetrics().highWater == 2, "PRIORITY: только глубина");
+
+        Queue<int> plain;
+        assertException([&]() { plain.GetMetrics(); }, "Метрики не включены");
+    }
+#endif
+
+    void testAdaptiveQueue() {
+        std::cout << "\n--- Тестирование ADAPTIVE ---" << std::endl;
+
+        Queue<int> adaptive(Queue<int>::ADAPTIVE);
+        Queue<int> reference(Queue<int>::ARRAY);
+        int logged = 0;
+        adaptive.SetMigrationLogger([&logged](const std::string&) { logged++; });
+        assertEqual(std::string(Queue<int>::StorageName(adaptive.GetStorageType())), std::string("ARRAY"), "ADAPTIVE начинает с массива");
+
+        for (int i = 0; i < 2000; i++) {
+            adaptive.Enqueue(i);
+            reference.Enqueue(i);
+        }
+        // Фаза Prepend: массив сдвигает всё на каждой операции
+        for (int i = 0; i < 2000; i++) {
+            adaptive.Prepend(-i);
+            reference.Prepend(-i);
+            adaptive.RemoveAt(adaptive.GetLength() - 1);
+            reference.RemoveAt(reference.GetLength() - 1);
+        }
+        assertEqual(std::string(Queue<int>::StorageName(adaptive.GetStorageType())), std::string("RING"), "Prepend-фаза переводит в RING");
+        assertTrue(logged == adaptive.GetMigrationLog().GetLength() && logged >= 1, "Перенос записан в журнал");
+        assertEqual(adaptive.ToString(), reference.ToString(), "Содержимое после переноса");
+
+        // Крупные элементы и вставки у начала: список не двигает элементы
+        Queue<Person> people(Queue<Person>::ADAPTIVE);
+        for (int i = 0; i < 200; i++) {
+            people.Enqueue(Person(PersonID{i, i}, "Name" + std::to_string(i), "M", "Last", 0));
+        }
+        for (int i = 0; i < 1500; i++) {
+            people.InsertAt(Person(PersonID{-i, 0}, "Inserted", "M", "Last", 0), 1 + i % 3);
+            people.RemoveAt(2);
+        }
+        assertEqual(std::string(Queue<Person>::StorageName(people.GetStorageType())), std::string("LINKED_LIST"),
+                    "Вставки у начала крупных элементов — список");
+
+        // operator[] только считает чтения: перенос не трогает хранилище под выданной ссылкой
+        Person& held = people[5];
+        PersonID heldID = held.GetID();
+        for (int i = 0; i < 1000; i++) {
+            people[(i * 37) % people.GetLength()].GetID();
+        }
+        assertTrue(held.GetID() == heldID && &held == &people[5], "Ссылка из operator[] переживает чтения");
+        assertEqual(std::string(Queue<Person>::StorageName(people.GetStorageType())), std::string("LINKED_LIST"),
+                    "operator[] не переносит хранилище");
+
+        // Фаза чтений по индексу с редкими Dequeue: список проходит от головы,
+        // массив сдвигает крупные элементы, кольцо дешевле обоих
+        long long sum = 0;
+        for (int i = 0; i < 3000; i++) {
+            sum += people.Get((i * 37) % people.GetLength()).GetID().series;
+            if (i % 100 == 0) people.Enqueue(people.Dequeue());
+        }
+        assertEqual(std::string(Queue<Person>::StorageName(people.GetStorageType())), std::string("RING"), "Чтения по индексу уводят со списка");
+        assertEqual(people.GetLength(), 200, "Длина после всех фаз");
+
+        // Параллельные const-чтения только копят атомарные счётчики; в cost их переносит Adapt()
+        const Queue<int>& shared = adaptive;
+        long long expected = 0;
+        for (int i = 0; i < shared.GetLength(); i++) expected += shared.Get(i);
+        std::vector<long long> sums(4, 0);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; t++) {
+            readers.emplace_back([&shared, &sums, t]() {
+                for (int i = 0; i < shared.GetLength(); i++) sums[t] += shared.Get(i);
+            });
+        }
+        for (auto& reader : readers) reader.join();
+        assertTrue(std::all_of(sums.begin(), sums.end(), [expected](long long sum) { return sum == expected; }),
+                   "Параллельные const-чтения ADAPTIVE");
+        adaptive.Enqueue(adaptive.Dequeue());
+        reference.Enqueue(reference.Dequeue());
+        assertEqual(adaptive.ToString(), reference.ToString(), "Изменение после параллельных чтений");
+
+        Queue<int> copy(adaptive);
+        assertTrue(copy.IsAdaptive() && copy.GetStorageType() == Queue<int>::RING, "Копия остаётся адаптивной");
+        Queue<int> plain;
+        assertException([&]() { plain.GetMigrationLog(); }, "Журнал только у ADAPTIVE");
+    }
+
+    void testStaticQueue() {
+        std::cout << "\n--- Тестирование Queue<T, StoragePolicy> ---" << std::endl;
+
+        Queue<int, RingStorage> ring;
+        for (int i = 0; i < 10; i++) ring.Enqueue(i);
+        for (int i = 0; i < 6; i++) ring.Dequeue();
+        for (int i = 10; i < 14; i++) ring.Enqueue(i);
+        assertEqual(ring.ToString(), std::string("[6, 7, 8, 9, 10, 11, 12, 13]"), "RingStorage FIFO");
+        assertEqual(ring[7], 13, "RingStorage operator[]");
+        assertEqual(ring.Reduce([](int a, int b) { return a + b; }, 0), 76, "RingStorage Reduce");
+        assertFalse(std::is_polymorphic_v<Queue<int, RingStorage>>, "Без таблицы виртуальных функций");
+
+        Queue<std::string, LinkedListStorage> list = {"a", "bb", "ccc"};
+        auto longOnes = list.Filter([](std::string s) { return s.size() > 1; });
+        assertTrue(std::is_same_v<decltype(longOnes), std::shared_ptr<Queue<std::string, LinkedListStorage>>>,
+                   "Filter сохраняет политику");
+        assertEqual(longOnes->Peek(), std::string("bb"), "LinkedListStorage Filter");
+
+        Queue<Person, ArrayStorage> persons;
+        Person person(PersonID{1, 2}, "Anna", "A", "Ivanova", 0);
+        persons.Enqueue(person);
+        Queue<Person, ArrayStorage> copy = persons;
+        persons.Dequeue();
+        assertTrue(copy.Contains(person) && persons.IsEmpty(), "Копия ArrayStorage независима");
+        assertException([&]() { persons.Dequeue(); }, "Dequeue из пустой статической очереди");
+        assertEqual(std::string(Queue<int, ArrayStorage>::StorageName()), std::string("ARRAY"), "Имя политики");
+    }
+
+    void testSpillQueue() {
+        std::cout << "\n--- Тестирование SpillQueue ---" << std::endl;
+
+        std::filesystem::path directory = std::filesystem::temp_directory_path() /
+                                          ("lb3_spill_test_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()));
+        std::filesystem::create_directories(directory);
+        auto fileCount = [&directory]() {
+            return std::distance(std::filesystem::directory_iterator(directory), std::filesystem::directory_iterator());
+        };
+
+        const int SEGMENT = 100;
+        const std::size_t budget = 6 * SEGMENT * sizeof(int);
+        {
+            SpillQueue<int> queue(budget, SEGMENT, directory);
+            std::size_t peak = 0;
+            int next = 0;
+            int expected = 0;
+            bool ordered = true;
+            // Всплеск, затем чередование записи и чтения, затем полный слив
+            for (int i = 0; i < 5000; i++) {
+                queue.Enqueue(next++);
+                peak = std::max(peak, queue.GetMemoryBytes());
+            }
+            assertTrue(queue.GetSpilledSegmentCount() > 0 && fileCount() == queue.GetSpilledSegmentCount(), "Средние сегменты на диске");
+            for (int i = 0; i < 3000; i++) {
+                queue.Enqueue(next++);
+                if (queue.Dequeue() != expected++) ordered = false;
+                if (queue.Dequeue() != expected++) ordered = false;
+                peak = std::max(peak, queue.GetMemoryBytes());
+            }
+            while (!queue.IsEmpty()) {
+                if (queue.Dequeue() != expected++) ordered = false;
+                peak = std::max(peak, queue.GetMemoryBytes());
+            }
+            assertTrue(ordered && expected == next, "FIFO через выгрузку");
+            assertTrue(peak <= budget + SEGMENT * sizeof(int), "Память в пределах бюджета");
+            assertEqual(static_cast<int>(fileCount()), 0, "Прочитанные файлы удалены");
+            assertException([&]() { queue.Dequeue(); }, "Dequeue из пустой SpillQueue");
+        }
+
+        {
+            SpillQueue<Person> persons(4096, 8, directory);
+            for (int i = 0; i < 200; i++) {
+                persons.Enqueue(Person(PersonID{i, i}, "Имя с пробелом " + std::to_string(i), "M", "L", i));
+            }
+            assertTrue(persons.GetSpillCount() > 0, "Person выгружаются");
+            Person first = persons.Dequeue();
+            for (int i = 1; i < 150; i++) persons.Dequeue();
+            Person later = persons.Dequeue();
+            assertTrue(first.GetFirstName() == "Имя с пробелом 0" && later.GetID().series == 150 &&
+                       later.GetBirthDate() == 150, "Person после подкачки");
+        }
+        assertEqual(static_cast<int>(fileCount()), 0, "Деструктор удаляет файлы");
+        std::filesystem::remove_all(directory);
+    }
+
+    void testSpscQueue() {
+        std::cout << "\n--- Тестирование SpscQueue ---" << std::endl;
+
+        SpscQueue<int> queue(3);
+        assertEqual(queue.GetCapacity(), 4, "Ёмкость округляется до степени двойки");
+        for (int i = 0; i < 4; i++) {
+            queue.Enqueue(i);
+        }
+        assertFalse(queue.TryEnqueue(4), "TryEnqueue в полную очередь");
+        assertEqual(queue.Peek(), 0, "SPSC Peek");
+        assertEqual(queue.Dequeue(), 0, "SPSC Dequeue");
+        assertTrue(queue.TryEnqueue(4), "TryEnqueue после освобождения слота");
+        int value = -1;
+        for (int expected = 1; expected <= 4; expected++) {
+            assertTrue(queue.TryDequeue(value) && value == expected,
+                       "SPSC порядок через границу буфера: " + std::to_string(expected));
+        }
+        assertFalse(queue.TryDequeue(value), "TryDequeue из пустой очереди");
+        assertException([&]() { queue.Peek(); }, "SPSC Peek empty exception");
+
+        const int COUNT = 100000;
+        SpscQueue<std::string> stringQueue(64);
+        std::thread producer([&]() {
+            for (int i = 0; i < COUNT; i++) {
+                stringQueue.Enqueue(std::to_string(i));
+            }
+        });
+        bool ordered = true;
+        for (int i = 0; i < COUNT; i++) {
+            if (stringQueue.Dequeue() != std::to_string(i)) ordered = false;
+        }
+        producer.join();
+        assertTrue(ordered, "SPSC порядок между потоками");
+        assertTrue(stringQueue.IsEmpty(), "SPSC пуста после передачи");
+    }
+
+    void testMpmcQueue() {
+        std::cout << "\n--- Тестирование MpmcQueue ---" << std::endl;
+
+        MpmcQueue<int> queue(4);
+        int batch[6] = {1, 2, 3, 4, 5, 6};
+        assertEqual(queue.TryEnqueueN(batch, 6), 4, "TryEnqueueN ограничен ёмкостью");
+        assertFalse(queue.TryEnqueue(7), "MPMC TryEnqueue в полную очередь");
+
+        int out[6] = {};
+        assertEqual(queue.TryDequeueN(out, 3), 3, "TryDequeueN частичный");
+        assertEqual(out[2], 3, "MPMC порядок в пакете");
+        assertEqual(queue.TryEnqueueN(batch + 4, 2), 2, "TryEnqueueN через границу буфера");
+        assertEqual(queue.TryDequeueN(out, 6), 3, "TryDequeueN остаток");
+        assertEqual(out[0] * 100 + out[1] * 10 + out[2], 456, "MPMC порядок после переноса");
+        assertEqual(queue.TryDequeueN(out, 6), 0, "TryDequeueN из пустой очереди");
+        queue.Enqueue(9);
+        assertEqual(queue.TryEnqueueN(batch, 0), 0, "TryEnqueueN нуля элементов");
+        assertEqual(queue.TryDequeueN(out, 0), 0, "TryDequeueN нуля элементов");
+        assertEqual(queue.Dequeue(), 9, "Элемент на месте после пакетов нулевой длины");
+
+        MpmcQueue<Complex> complexQueue(8);
+        complexQueue.Enqueue(Complex(1, 2));
+        assertEqual(complexQueue.Dequeue(), Complex(1, 2), "MPMC Complex");
+
+        MpmcQueue<Person> personQueue(8);
+        Person person(PersonID{1, 2}, "Ivan", "I", "Ivanov", 0);
+        personQueue.Enqueue(person);
+        assertTrue(personQueue.Dequeue() == person, "MPMC Person");
+
+        const int THREADS = 4;
+        const int PER_THREAD = 20000;
+        MpmcQueue<std::string> stringQueue(256);
+        std::atomic<long long> consumedSum{0};
+        std::atomic<int> consumedCount{0};
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; t++) {
+            threads.emplace_back([&, t]() {
+                for (int i = 0; i < PER_THREAD; i++) {
+                    stringQueue.Enqueue(std::to_string(t * PER_THREAD + i));
+                }
+            });
+            threads.emplace_back([&]() {
+                std::string items[16];
+                int received = 0;
+                while (received < PER_THREAD) {
+                    int n = stringQueue.TryDequeueN(items, std::min(16, PER_THREAD - received));
+                    if (n == 0) std::this_thread::yield();
+                    for (int i = 0; i < n; i++) {
+                        consumedSum += std::stoll(items[i]);
+                    }
+                    received += n;
+                }
+                consumedCount += received;
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        const long long total = 1LL * THREADS * PER_THREAD;
+        assertEqual(consumedCount.load(), THREADS * PER_THREAD, "MPMC все элементы получены");
+        assertEqual(consumedSum.load(), total * (total - 1) / 2, "MPMC сумма без потерь и повторов");
+    }
+
+    void testBroadcastQueue() {
+        std::cout << "\n--- Тестирование BroadcastQueue ---" << std::endl;
+
+        BroadcastQueue<int> ring(4);
+        auto fast = ring.Subscribe();
+        auto slow = ring.Subscribe();
+        for (int i = 0; i < 4; i++) {
+            ring.Enqueue(i);
+        }
+        assertFalse(ring.TryEnqueue(4), "Запись ждёт самого медленного");
+
+        auto span = fast.ReadBatch(10);
+        assertEqual(span.size, 4, "ReadBatch отдаёт опубликованное");
+        int sum = 0;
+        for (int value : span) sum += value;
+        fast.Commit();
+        assertEqual(sum, 6, "Участок без копирования");
+        assertFalse(ring.TryEnqueue(4), "Быстрый подписчик не освобождает ячейки");
+
+        assertEqual(slow.Read(), 0, "Медленный видит тот же элемент");
+        assertEqual(slow.Read(), 1, "Медленный читает по порядку");
+        assertTrue(ring.TryEnqueue(4) && ring.TryEnqueue(5), "Освобождённые ячейки переиспользуются");
+
+        span = fast.ReadBatch(10);
+        assertEqual(span.size, 2, "Участок не переходит через конец кольца");
+        fast.Commit();
+        assertEqual(slow.GetLag(), static_cast<std::int64_t>(4), "Отставание медленного");
+        assertException([&]() { ring.Subscribe(); }, "Подписка после начала записи");
+
+        // Два производителя, три подписчика: каждый видит все элементы
+        const int PER_PRODUCER = 20000;
+        BroadcastQueue<std::int64_t> shared(64);
+        std::vector<BroadcastQueue<std::int64_t>::Consumer> consumers;
+        for (int c = 0; c < 3; c++) consumers.push_back(shared.Subscribe());
+        std::vector<std::int64_t> sums(3, 0);
+        std::vector<std::thread> threads;
+        for (int c = 0; c < 3; c++) {
+            threads.emplace_back([&, c]() {
+                int seen = 0;
+                while (seen < 2 * PER_PRODUCER) {
+                    auto batch = consumers[c].ReadBatch(32);
+                    if (batch.size == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    for (std::int64_t value : batch) sums[c] += value;
+                    seen += batch.size;
+                    consumers[c].Commit();
+                }
+            });
+        }
+        for (int p = 0; p < 2; p++) {
+            threads.emplace_back([&shared, p, PER_PRODUCER]() {
+                for (int i = 0; i < PER_PRODUCER; i++) shared.Enqueue(p * PER_PRODUCER + i + 1);
+            });
+        }
+        for (auto& thread : threads) thread.join();
+        std::int64_t expected = static_cast<std::int64_t>(2 * PER_PRODUCER) * (2 * PER_PRODUCER + 1) / 2;
+        assertTrue(sums[0] == expected && sums[1] == expected && sums[2] == expected, "Каждый подписчик получил все элементы");
+    }
+
+    void testBlockingQueue() {
+        std::cout << "\n--- Тестирование BlockingQueue ---" << std::endl;
+
+        BlockingQueue<int> queue;
+        queue.Enqueue(1);
+        queue.Enqueue(2);
+        int value = 0;
+        assertTrue(queue.Dequeue(value, std::chrono::milliseconds(0)), "Dequeue с таймаутом");
+        assertEqual(value, 1, "BlockingQueue FIFO");
+        assertEqual(queue.Dequeue(), 2, "Блокирующий Dequeue");
+        assertFalse(queue.Dequeue(value, std::chrono::milliseconds(10)), "Dequeue истёк таймаут");
+
+        BlockingQueue<int> rejecting(2, BlockingQueue<int>::REJECT);
+        rejecting.Enqueue(1);
+        rejecting.Enqueue(2);
+        assertFalse(rejecting.Enqueue(3), "REJECT при переполнении");
+        assertEqual(rejecting.GetRejectedCount(), 1LL, "Счётчик отклонённых");
+
+        BlockingQueue<std::string> dropping(2, BlockingQueue<std::string>::DROP_OLDEST);
+        dropping.Enqueue("a");
+        dropping.Enqueue("b");
+        assertTrue(dropping.Enqueue("c"), "DROP_OLDEST принимает элемент");
+        assertEqual(dropping.Dequeue(), "b", "DROP_OLDEST вытесняет старейший");
+        assertEqual(dropping.GetDroppedCount(), 1LL, "Счётчик вытесненных");
+
+        BlockingQueue<int> bounded(2);
+        bounded.Enqueue(1);
+        bounded.Enqueue(2);
+        std::atomic<bool> produced{false};
+        std::thread producer([&]() {
+            bounded.Enqueue(3);
+            produced = true;
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        assertFalse(produced.load(), "BLOCK ждёт свободного места");
+        ArraySequence<int> batch;
+        assertEqual(bounded.DequeueBatch(10, batch), 2, "DequeueBatch забирает всё");
+        producer.join();
+        assertTrue(produced.load(), "BLOCK продолжает после DequeueBatch");
+        assertEqual(bounded.Dequeue(), 3, "Элемент после ожидания");
+
+        BlockingQueue<int> closing;
+        std::atomic<int> woken{0};
+        std::vector<std::thread> consumers;
+        for (int i = 0; i < 3; i++) {
+            consumers.emplace_back([&]() {
+                ArraySequence<int> out;
+                if (closing.DequeueBatch(4, out) == 0) woken++;
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        closing.Close();
+        for (auto& consumer : consumers) {
+            consumer.join();
+        }
+        assertEqual(woken.load(), 3, "Close будит всех ждущих");
+        assertException([&]() { closing.DequeueBatch(0, batch); }, "DequeueBatch с maxCount 0");
+
+        // Пакет из очереди на списке: один проход, ожидание места посреди пакета
+        Queue<int> listed(Queue<int>::LINKED_LIST);
+        for (int i = 0; i < 10; i++) listed.Enqueue(i);
+        BlockingQueue<int> narrow(4);
+        std::thread batchProducer([&]() { narrow.EnqueueBatch(listed); });
+        bool batchOrdered = true;
+        for (int i = 0; i < 10; i++) {
+            if (narrow.Dequeue() != i) batchOrdered = false;
+        }
+        batchProducer.join();
+        assertTrue(batchOrdered, "EnqueueBatch ждёт места и сохраняет порядок");
+        BlockingQueue<int> rejectingBatch(2, BlockingQueue<int>::REJECT);
+        assertEqual(rejectingBatch.EnqueueBatch(listed), 2, "EnqueueBatch при REJECT");
+        assertEqual(rejectingBatch.GetRejectedCount(), 8LL, "Остаток пакета отклонён");
+        assertFalse(closing.Enqueue(1), "Enqueue в закрытую очередь");
+        assertException([&]() { closing.Dequeue(); }, "Dequeue из закрытой пустой очереди");
+    }
+
+    void testPipeline() {
+        std::cout << "\n--- Тестирование Pipeline ---" << std::endl;
+
+        ArraySequence<int> input;
+        for (int i = 1; i <= 1000; i++) input.Append(i);
+        ArraySequence<int> output;
+
+        Pipeline<int> pipeline(16, 8);
+        pipeline.Source(input)
+                .Map([](int x) { return x * 2; }, "Double")
+                .Where([](int x) { return x % 3 == 0; }, "Every3")
+                .Sink(output);
+        pipeline.Run();
+
+        assertEqual(output.GetLength(), 333, "Pipeline длина результата");
+        assertTrue(output.GetFirst() == 6 && output.GetLast() == 1998, "Pipeline сохраняет порядок");
+        auto metrics = pipeline.GetMetrics();
+        assertTrue(metrics[0].processed == 1000 && metrics[1].processed == 1000 && metrics[2].emitted == 333 &&
+                   metrics[3].processed == 333, "Счётчики стадий");
+        assertEqual(metrics[3].backlog, 0, "Очереди пусты после Run");
+
+        Pipeline<int> slow(4, 4);
+        int next = 0;
+        long long sum = 0;
+        slow.Source([&next](int& item) { item = next++; return item < 200; })
+            .Map([](int x) {
+                if (x % 20 == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                return x;
+            }, "Slow")
+            .Map([](int x) { return x + 1; }, "Fast")
+            .Sink([&sum](const int& x) { sum += x; });
+        slow.Run();
+        assertEqual(sum, 200LL * 201 / 2, "Pipeline с генератором");
+        assertEqual(slow.GetBottleneck(), std::string("Slow"), "Узкое место найдено");
+
+        Pipeline<int> failing(4, 2);
+        ArraySequence<int> ignored;
+        failing.Source(input)
+               .Map([](int x) {
+                   if (x == 500) throw std::runtime_error("Stage failed");
+                   return x;
+               })
+               .Sink(ignored);
+        assertException([&]() { failing.Run(); }, "Ошибка стадии пробрасывается из Wait");
+
+        // Источник из очереди на списке обходится одним проходом
+        Queue<int> listed(Queue<int>::LINKED_LIST);
+        for (int i = 1; i <= 20000; i++) listed.Enqueue(i);
+        long long listedSum = 0;
+        Pipeline<int> fromList(16, 8);
+        fromList.Source(listed).Sink([&listedSum](const int& x) { listedSum += x; });
+        fromList.Run();
+        assertEqual(listedSum, 20000LL * 20001 / 2, "Pipeline из Queue на списке");
+
+        Pipeline<int> invalid;
+        assertException([&]() { invalid.Map([](int x) { return x; }); }, "Стадия без источника");
+    }
+
+    void testWorkStealingPool() {
+        std::cout << "\n--- Тестирование WorkStealingPool ---" << std::endl;
+
+        WorkStealingDeque<int> deque(2);
+        for (int i = 0; i < 5; i++) {
+            deque.Push(i);
+        }
+        int value = -1;
+        assertTrue(deque.TrySteal(value), "Кража из дека");
+        assertEqual(value, 0, "Вор берёт старейший элемент");
+        assertTrue(deque.TryPop(value), "Владелец забирает элемент");
+        assertEqual(value, 4, "Владелец берёт новейший элемент");
+        assertEqual(deque.GetLength(), 3, "Длина дека после роста");
+
+        WorkStealingPool pool(4);
+        std::atomic<int> counter{0};
+        for (int i = 0; i < 1000; i++) {
+            pool.Submit([&]() {
+                // Задачи из рабочих потоков попадают в собственный дек
+                pool.Submit([&]() { counter++; });
+                counter++;
+            });
+        }
+        pool.Wait();
+        assertEqual(counter.load(), 2000, "Все задачи выполнены");
+
+        std::vector<int> squares(10000);
+        pool.ParallelFor(0, 10000, [&](int i) { squares[i] = i * i; }, 64);
+        bool correct = true;
+        for (int i = 0; i < 10000; i++) {
+            if (squares[i] != i * i) correct = false;
+        }
+        assertTrue(correct, "ParallelFor обходит весь диапазон");
+
+        std::atomic<long long> nested{0};
+        pool.ParallelFor(0, 8, [&](int) {
+            pool.ParallelFor(0, 100, [&](int j) { nested += j; });
+        });
+        assertEqual(nested.load(), 8LL * 4950, "Вложенный ParallelFor");
+        assertTrue(pool.GetExecutedCount() > 2000, "Счётчик выполненных задач");
+    }
+
+#if defined(__cpp_impl_coroutine)
+    static AsyncTask consumeAsync(AsyncQueue<int>& queue, int count, std::atomic<long long>& sum,
+                                  std::atomic<int>& finished) {
+        for (int i = 0; i < count; i++) {
+            sum += co_await queue.DequeueAsync();
+        }
+        finished++;
+    }
+
+    void testAsyncQueue() {
+        std::cout << "\n--- Тестирование AsyncQueue ---" << std::endl;
+
+        WorkStealingPool executor(2);
+        AsyncQueue<int> queue(executor);
+        queue.Enqueue(5);
+
+        std::atomic<long long> sum{0};
+        std::atomic<int> finished{0};
+        consumeAsync(queue, 1, sum, finished);
+        assertEqual(finished.load(), 1, "co_await без приостановки, если элемент есть");
+
+        const int CONSUMERS = 500;
+        sum = 0;
+        finished = 0;
+        for (int i = 0; i < CONSUMERS; i++) {
+            consumeAsync(queue, 2, sum, finished);
+        }
+        assertEqual(queue.GetWaiterCount(), CONSUMERS, "Корутины ждут элементов");
+        for (int i = 0; i < 2 * CONSUMERS; i++) {
+            queue.Enqueue(i);
+        }
+        executor.Wait();
+        assertEqual(finished.load(), CONSUMERS, "Все корутины возобновлены");
+        assertEqual(sum.load(), 1LL * CONSUMERS * (2 * CONSUMERS - 1), "Каждый элемент получен один раз");
+        assertEqual(queue.GetLength(), 0, "AsyncQueue пуста");
+    }
+#endif
+
+#if defined(__linux__)
+    void testSharedMemoryQueue() {
+        std::cout << "\n--- Тестирование SharedMemoryQueue ---" << std::endl;
+
+        const std::string name = "/lb3_queue_test_" + std::to_string(getpid());
+        SharedMemoryQueue<Complex>::Unlink(name);
+        SharedMemoryQueue<Complex> writer(name, 3);
+        SharedMemoryQueue<Complex> reader(name);
+        assertEqual(reader.GetCapacity(), 4, "Ёмкость из заголовка сегмента");
+
+        for (int i = 0; i < 4; i++) {
+            writer.Enqueue(Complex(i, -i));
+        }
+        assertFalse(writer.TryEnqueue(Complex(9, 9)), "Сегмент заполнен");
+        assertEqual(reader.Dequeue(), Complex(0, 0), "Чтение через второе отображение");
+        assertEqual(reader.GetLength(), 3, "Общая длина");
+
+        Complex item;
+        while (reader.TryDequeue(item)) {}
+        assertFalse(reader.Dequeue(item, std::chrono::milliseconds(10)), "Dequeue с таймаутом по futex");
+
+        std::thread producer([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            writer.Enqueue(Complex(7, 7));
+        });
+        assertEqual(reader.Dequeue(), Complex(7, 7), "Пробуждение через futex");
+        producer.join();
+
+        assertException([&]() { SharedMemoryQueue<PersonID> wrongType(name); }, "Открытие с чужим типом элемента");
+        SharedMemoryQueue<Complex>::Unlink(name);
+        assertException([&]() { SharedMemoryQueue<Complex> missing(name); }, "Открытие удалённого сегмента");
+    }
+
+    void testPersistentQueue() {
+        std::cout << "\n--- Тестирование PersistentQueue ---" << std::endl;
+
+        const std::string directory = "/tmp/lb3_persistent_test_" + std::to_string(getpid());
+        std::filesystem::remove_all(directory);
+
+        PersistentQueueOptions options;
+        options.segmentBytes = 256;
+        {
+            PersistentQueue<std::string> queue(directory, options);
+            for (int i = 0; i < 40; i++) {
+                queue.Enqueue("item number " + std::to_string(i));
+            }
+            assertTrue(queue.GetSegmentCount() > 1, "Журнал разбит на сегменты");
+            assertEqual(queue.Dequeue(), "item number 0", "Строка с пробелами из журнала");
+            for (int i = 1; i < 20; i++) {
+                queue.Dequeue();
+            }
+        }
+        {
+            PersistentQueue<std::string> queue(directory, options);
+            assertEqual(queue.GetLength(), 20, "Длина после переоткрытия");
+            assertEqual(queue.Peek(), "item number 20", "Позиция чтения сохранена");
+            int segmentsBefore = queue.GetSegmentCount();
+            while (!queue.IsEmpty()) {
+                queue.Dequeue();
+            }
+            assertTrue(queue.GetSegmentCount() < segmentsBefore, "Дочитанные сегменты удалены");
+            assertException([&]() { queue.Dequeue(); }, "Dequeue из пустой персистентной очереди");
+            queue.Enqueue("after drain");
+        }
+
+        // Оборванная запись в конце хвостового сегмента
+        std::filesystem::path tail;
+        for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+            if (entry.path().extension() == ".seg" && (tail.empty() || entry.path() > tail)) tail = entry.path();
+        }
+        auto tailSize = std::filesystem::file_size(tail);
+        {
+            // Заявлено 16 байт данных, дописано только 3 после crc
+            const char torn[] = "\x10\x00\x00\x00garbage";
+            std::ofstream file(tail, std::ios::binary | std::ios::app);
+            file.write(torn, sizeof torn - 1);
+        }
+        assertEqual(static_cast<int>(std::filesystem::file_size(tail) - tailSize), 11, "Оборванная запись дописана целиком");
+        {
+            PersistentQueue<std::string> queue(directory, options);
+            assertEqual(queue.GetLength(), 1, "Восстановление отрезает битый хвост");
+            assertEqual(static_cast<int>(std::filesystem::file_size(tail)), static_cast<int>(tailSize),
+                        "Оборванная запись отрезана");
+            assertEqual(queue.Peek(), "after drain", "Целая запись пережила восстановление");
+        }
+
+        // Запись полной длины, но с неверной контрольной суммой
+        {
+            const char corrupt[] = "\x05\x00\x00\x00\xef\xbe\xad\xde" "hello";
+            std::ofstream file(tail, std::ios::binary | std::ios::app);
+            file.write(corrupt, sizeof corrupt - 1);
+        }
+        {
+            PersistentQueue<std::string> queue(directory, options);
+            assertEqual(queue.GetLength(), 1, "Запись с неверным crc отброшена");
+            assertEqual(static_cast<int>(std::filesystem::file_size(tail)), static_cast<int>(tailSize),
+                        "Запись с неверным crc отрезана");
+            assertEqual(queue.Dequeue(), "after drain", "Целая запись пережила неверный crc");
+        }
+        std::filesystem::remove_all(directory);
+
+        const std::string personDirectory = directory + "_person";
+        std::filesystem::remove_all(personDirectory);
+        Person person(PersonID{12, 34}, "Anna", "B", "Smith", 86400);
+        {
+            PersistentQueue<Person> queue(personDirectory);
+            queue.Enqueue(person);
+        }
+        {
+            PersistentQueue<Person> queue(personDirectory);
+            Person loaded = queue.Dequeue();
+            assertTrue(loaded == person && loaded.GetFullName() == person.GetFullName() &&
+                       loaded.GetBirthDate() == person.GetBirthDate(), "Person из журнала");
+        }
+        std::filesystem::remove_all(personDirectory);
+
+        // Срок syncInterval соблюдается без новых Enqueue и явного Commit
+        const std::string timedDirectory = directory + "_timed";
+        std::filesystem::remove_all(timedDirectory);
+        PersistentQueueOptions timed;
+        timed.syncEveryRecords = 0;
+        timed.syncInterval = std::chrono::milliseconds(200);
+        {
+            PersistentQueue<int> queue(timedDirectory, timed);
+            queue.Enqueue(42);
+            std::filesystem::path segment = std::filesystem::path(timedDirectory) / "00000000000000000000.seg";
+            assertEqual(static_cast<int>(std::filesystem::file_size(segment)), 0, "Запись ждёт в буфере до срока");
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (std::filesystem::file_size(segment) == 0 && std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+            assertTrue(std::filesystem::file_size(segment) > 0, "Фоновая фиксация по syncInterval");
+            assertEqual(queue.Dequeue(), 42, "Запись после фоновой фиксации");
+        }
+        std::filesystem::remove_all(timedDirectory);
+    }
+
+    void testBinarySnapshot() {
+        std::cout << "\n--- Тестирование двоичных снимков ---" << std::endl;
+
+        const std::string filename = "/tmp/lb3_snapshot_test_" + std::to_string(getpid()) + ".bin";
+
+        Queue<std::string> strings(Queue<std::string>::RING);
+        strings.Enqueue("hello world");
+        strings.Enqueue("");
+        strings.Enqueue("с пробелами и юникодом");
+        strings.SerializeBinary(filename);
+        {
+            SnapshotView<std::string> view(filename);
+            assertEqual(view.GetLength(), 3, "Длина снимка строк");
+            assertTrue(view.Get(2) == "с пробелами и юникодом", "string_view без копирования");
+        }
+        Queue<std::string> loadedStrings;
+        loadedStrings.Enqueue("stale");
+        loadedStrings.DeserializeBinary(filename);
+        assertEqual(loadedStrings.ToString(), strings.ToString(), "Строки с пробелами после загрузки");
+
+        ArraySequence<Complex> complexes = {Complex(1, 2), Complex(3, -4)};
+        complexes.SerializeBinary(filename);
+        {
+            SnapshotView<Complex> view(filename);
+            assertEqual(view.Data()[1], Complex(3, -4), "Сырой массив Complex в файле");
+        }
+        ArraySequence<Complex> loadedComplexes;
+        loadedComplexes.DeserializeBinary(filename);
+        assertEqual(loadedComplexes.ToString(), complexes.ToString(), "ArraySequence<Complex> после загрузки");
+
+        // Список кодируется одним проходом, а не Get(i) на каждый элемент
+        Queue<int> listed(Queue<int>::LINKED_LIST);
+        for (int i = 0; i < 200000; i++) {
+            listed.Enqueue(i);
+        }
+        listed.SerializeBinary(filename);
+        {
+            SnapshotView<int> view(filename);
+            assertTrue(view.GetLength() == 200000 && view.Data()[0] == 0 && view.Data()[199999] == 199999,
+                       "Снимок очереди на списке");
+        }
+
+        Person person(PersonID{5, 6}, "Petr", "P", "Petrov", 1000);
+        Queue<Person> persons;
+        persons.Enqueue(person);
+        persons.SerializeBinary(filename);
+        Queue<Person> loadedPersons;
+        loadedPersons.DeserializeBinary(filename);
+        assertTrue(loadedPersons.Peek() == person && loadedPersons.Peek().GetFullName() == person.GetFullName(),
+                   "Person после загрузки");
+
+        assertException([&]() { SnapshotView<double> wrongType(filename); }, "Снимок чужого типа");
+        std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 1);
+        assertException([&]() { SnapshotView<Person> truncated(filename); }, "Обрезанный снимок");
+
+        // Размер std::string зависит от ABI и для offsets-разметки не сверяется
+        strings.SerializeBinary(filename);
+        {
+            std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+            std::uint32_t foreignSize = 1;
+            file.seekp(offsetof(SnapshotHeader, elementSize));
+            file.write(reinterpret_cast<const char*>(&foreignSize), sizeof(foreignSize));
+        }
+        {
+            SnapshotView<std::string> view(filename);
+            assertTrue(view.GetLength() == 3 && view.Get(0) == "hello world", "Строки с другим elementSize");
+        }
+        Queue<std::string> foreignStrings;
+        DeserializeBinaryReadAhead(filename, foreignStrings);
+        assertEqual(foreignStrings.ToString(), strings.ToString(), "Потоковое чтение строк с другим elementSize");
+
+        // Подделанный count: count * sizeof(T) и (count + 1) * 8 переполняются до размера файла
+        auto writeForged = [&](std::uint32_t layout, std::uint32_t elementSize, std::uint64_t count,
+                               std::uint64_t payloadBytes) {
+            SnapshotHeader header{{'L', 'B', '3', 'S'}, SNAPSHOT_VERSION, layout, elementSize, count, payloadBytes};
+            std::string payload(payloadBytes, '\0');
+            std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+        };
+        writeForged(SNAPSHOT_RAW, sizeof(int), (std::uint64_t(1) << 62) + 1, sizeof(int));
+        assertException([&]() { SnapshotView<int> forged(filename); }, "Переполнение count * sizeof(T)");
+        ArraySequence<int> forgedInts;
+        assertException([&]() { DeserializeBinaryReadAhead(filename, forgedInts); },
+                        "Переполнение count * sizeof(T) при потоковом чтении");
+        writeForged(SNAPSHOT_OFFSETS, sizeof(std::string), (std::uint64_t(1) << 61) - 1, sizeof(std::uint64_t));
+        assertException([&]() { SnapshotView<std::string> forged(filename); }, "Переполнение (count + 1) * 8");
+        Queue<std::string> forgedStrings;
+        assertException([&]() { DeserializeBinaryReadAhead(filename, forgedStrings); },
+                        "Переполнение (count + 1) * 8 при потоковом чтении");
+        std::remove(filename.c_str());
+    }
+
+    void testAsyncSerialization() {
+        std::cout << "\n--- Тестирование асинхронной сериализации ---" << std::endl;
+
+        const std::string filename = "/tmp/lb3_async_test_" + std::to_string(getpid()) + ".bin";
+        std::vector<IoBackend> backends = {IO_THREAD_POOL};
+        if (IoUring::IsSupported()) backends.push_back(IO_URING);
+
+        for (IoBackend backend : backends) {
+            std::string name = backend == IO_URING ? "io_uring" : "пул потоков";
+
+            // Больше нескольких кусков, чтобы проверить порядок и перекрытие чтений
+            Queue<double> values(Queue<double>::RING);
+            for (int i = 0; i < 400000; i++) {
+                values.Enqueue(i * 0.25);
+            }
+            std::future<std::uint64_t> written = SerializeBinaryAsync(values, filename, backend);
+            values.Enqueue(-1.0);
+            std::uint64_t bytes = written.get();
+            assertEqual(bytes, static_cast<std::uint64_t>(std::filesystem::file_size(filename)),
+                        "Размер файла (" + name + ")");
+            ArraySequence<double> loadedValues;
+            DeserializeBinaryReadAhead(filename, loadedValues, backend);
+            assertEqual(loadedValues.GetLength(), 400000, "Длина double после чтения (" + name + ")");
+            assertEqual(loadedValues.Get(399999), 399999 * 0.25, "Последний double (" + name + ")");
+
+            Queue<std::string> strings;
+            for (int i = 0; i < 100000; i++) {
+                strings.Enqueue("строка " + std::to_string(i));
+            }
+            SerializeBinaryAsync(strings, filename, backend).get();
+            Queue<std::string> loadedStrings;
+            loadedStrings.Enqueue("stale");
+            DeserializeBinaryReadAhead(filename, loadedStrings, backend);
+            assertTrue(loadedStrings.GetLength() == 100000 && loadedStrings.Peek() == "строка 0" &&
+                       loadedStrings.Get(99999) == "строка 99999", "Строки через границы кусков (" + name + ")");
+
+            Person person(PersonID{7, 8}, "Ivan", "I", "Ivanov", 2000);
+            Queue<Person> persons;
+            persons.Enqueue(person);
+            SerializeBinaryAsync(persons, filename, backend).get();
+            Queue<Person> loadedPersons;
+            DeserializeBinaryReadAhead(filename, loadedPersons, backend);
+            assertTrue(loadedPersons.GetLength() == 1 && loadedPersons.Peek() == person, "Person (" + name + ")");
+
+            // Больше IO_QUEUE_DEPTH кусков: потребитель падает, пока чтения ещё в полёте
+            Queue<double> many(Queue<double>::RING);
+            for (int i = 0; i < 3000000; i++) {
+                many.Enqueue(i);
+            }
+            SerializeBinaryAsync(many, filename, backend).get();
+            ArraySequence<int> wrongType;
+            assertException([&]() { DeserializeBinaryReadAhead(filename, wrongType, backend); },
+                            "Чужой тип в крупном снимке (" + name + ")");
+            int consumed = 0;
+            assertException([&]() {
+                ReadFileAhead(filename, [&](const char*, std::size_t) {
+                    if (++consumed == 3) throw std::runtime_error("consumer failed");
+                }, backend);
+            }, "Ошибка потребителя посреди файла (" + name + ")");
+            assertEqual(consumed, 3, "Чтение остановлено на упавшем куске (" + name + ")");
+        }
+
+        // Ошибка записи при полной очереди io_uring: остальные записи ещё в полёте
+        if (IoUring::IsSupported()) {
+            std::vector<IoChunk> chunks;
+            for (unsigned i = 0; i < 2 * IO_QUEUE_DEPTH; i++) {
+                chunks.emplace_back(static_cast<std::uint64_t>(i) * IoChunk::CAPACITY);
+                chunks.back().size = IoChunk::CAPACITY;
+            }
+            int readOnly = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+            assertException([&]() { WriteChunksUring(readOnly, chunks); }, "Ошибка записи io_uring при записях в полёте");
+            close(readOnly);
+        }
+
+        std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 1);
+        Queue<Person> truncated;
+        assertException([&]() { DeserializeBinaryReadAhead(filename, truncated); }, "Обрезанный снимок при чтении");
+        std::remove(filename.c_str());
+    }
+
+    void testMappedArrayGrowth() {
+        std::cout << "\n--- Тестирование роста ArraySequence через mremap ---" << std::endl;
+
+        const int COUNT = 6000000;
+        ArraySequence<double> seq;
+        for (int i = 0; i < COUNT; i++) seq.Append(i * 0.5);
+        assertTrue(seq.IsMapped(), "Крупный буфер отображён напрямую");
+        assertTrue(seq.Get(0) == 0.0 && seq.Get(COUNT / 3) == (COUNT / 3) * 0.5 && seq.GetLast() == (COUNT - 1) * 0.5,
+                   "Значения после mremap");
+
+        ArraySequence<double> copy(seq);
+        copy.RemoveAt(0);
+        assertTrue(copy.IsMapped() && copy.GetFirst() == 0.5 && seq.GetFirst() == 0.0, "Копия отображённого буфера");
+
+        while (copy.GetLength() > 1000) copy.RemoveAt(copy.GetLength() - 1);
+        copy.ShrinkToFit();
+        assertTrue(!copy.IsMapped() && copy.GetLast() == 500.0, "Сжатие возвращает буфер в кучу");
+
+        ArraySequence<std::string> strings(COUNT);
+        assertFalse(strings.IsMapped(), "Нетривиальные элементы не отображаются");
+    }
+#endif
+
     void testFunctionalOperations() {
         std::cout << "\n--- Тестирование функциональных операций ---" << std::endl;
         
@@ -1185,7 +8304,1065 @@ public:
         end = std::chrono::high_resolution_clock::now();
         auto mapTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
         std::cout << "Map операция: " << mapTime.count() << "ms" << std::endl;
+
+        // Опустошение очереди: ARRAY сдвигает массив на каждом Dequeue, RING — нет
+        for (auto type : {Queue<int>::ARRAY, Queue<int>::RING}) {
+            Queue<int> queue(type);
+            for (int i = 0; i < LARGE_SIZE; i++) {
+                queue.Enqueue(i);
+            }
+            start = std::chrono::high_resolution_clock::now();
+            long long drained = 0;
+            while (!queue.IsEmpty()) {
+                drained += queue.Dequeue();
+            }
+            end = std::chrono::high_resolution_clock::now();
+            auto drainTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+            std::cout << (type == Queue<int>::ARRAY ? "ARRAY" : "RING")
+                      << " Dequeue x" << LARGE_SIZE << ": " << drainTime.count() << "us" << std::endl;
+            assertEqual(drained, 1LL * LARGE_SIZE * (LARGE_SIZE - 1) / 2, "Drain sum");
+        }
+    }
+
+    void testArrayStoragePerformance() {
+        std::cout << "\n--- ArraySequence<std::string>: копия, перемещение, Emplace ---" << std::endl;
+
+        const int COUNT = 500000;
+        std::string pattern(48, 'x');
+        long long checksum = 0;
+
+        auto measure = [&](const std::string& name, auto fill) {
+            auto start = std::chrono::high_resolution_clock::now();
+            ArraySequence<std::string> seq;
+            fill(seq);
+            auto end = std::chrono::high_resolution_clock::now();
+            checksum += seq.GetLength();
+            std::cout << name << ": " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+        };
+
+        measure("Append(const T&)", [&](ArraySequence<std::string>& seq) {
+            for (int i = 0; i < COUNT; i++) {
+                std::string item = pattern;
+                seq.Append(item);
+            }
+        });
+        measure("Append(T&&)", [&](ArraySequence<std::string>& seq) {
+            for (int i = 0; i < COUNT; i++) {
+                std::string item = pattern;
+                seq.Append(std::move(item));
+            }
+        });
+        measure("Reserve + Emplace", [&](ArraySequence<std::string>& seq) {
+            seq.Reserve(COUNT);
+            for (int i = 0; i < COUNT; i++) {
+                seq.Emplace(pattern);
+            }
+        });
+        assertEqual(checksum, 3LL * COUNT, "String append count");
+
+        auto start = std::chrono::high_resolution_clock::now();
+        ArraySequence<Person> persons(COUNT);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "ArraySequence<Person>(" << COUNT << ") без конструирования: "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us" << std::endl;
+    }
+
+    void testSmallArrayPerformance() {
+        std::cout << "\n--- Короткие последовательности: куча против встроенного буфера ---" << std::endl;
+
+        const int ROUNDS = 1000000;
+        const int ITEMS = 12;
+
+        auto run = [&](auto make) {
+            long long sum = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int round = 0; round < ROUNDS; round++) {
+                auto seq = make();
+                for (int i = 0; i < ITEMS; i++) seq.Append(round + i);
+                sum += seq.GetLast();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::make_pair(sum, std::chrono::duration_cast<std::chrono::milliseconds>(end - start));
+        };
+
+        auto heap = run([] { return ArraySequence<int>(); });
+        auto small = run([] { return SmallArraySequence<int>(); });
+        assertEqual(small.first, heap.first, "Small sum");
+        std::cout << "ArraySequence<int>, " << ROUNDS << " x " << ITEMS << " элементов: " << heap.second.count() << "ms" << std::endl;
+        std::cout << "SmallArraySequence<int, 16>: " << small.second.count() << "ms" << std::endl;
+    }
+
+    void testTrivialRelocationPerformance() {
+        std::cout << "\n--- ArraySequence: побайтовый перенос против поэлементного ---" << std::endl;
+
+        const int COUNT = 1000000;
+        const int SHIFTS = 200;
+
+        // Рост до COUNT элементов, затем SHIFTS вставок и удалений в начале
+        auto run = [&](auto tag) {
+            using Item = decltype(tag);
+            auto start = std::chrono::high_resolution_clock::now();
+            ArraySequence<Item> seq;
+            for (int i = 0; i < COUNT; i++) seq.Append(Item(i));
+            auto grown = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < SHIFTS; i++) {
+                seq.InsertAt(Item(i), 0);
+                seq.RemoveAt(0);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(grown - start).count() << "ms рост, "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(end - grown).count() << "ms сдвиги" << std::endl;
+            return seq.Get(COUNT / 2);
+        };
+
+        std::cout << "int (memmove/realloc): ";
+        int plain = run(int());
+        std::cout << "int (поэлементно): ";
+        int boxed = run(OpaqueValue<int>()).value;
+        assertEqual(boxed, plain, "Relocation int");
+
+        std::cout << "Complex (memmove/realloc): ";
+        Complex plainComplex = run(Complex());
+        std::cout << "Complex (поэлементно): ";
+        Complex boxedComplex = run(OpaqueValue<Complex>()).value;
+        assertTrue(plainComplex == boxedComplex, "Relocation Complex");
+    }
+
+    void testRangePerformance() {
+        std::cout << "\n--- Групповые операции против поэлементных ---" << std::endl;
+
+        const int SIZE = 100000;
+        const int CHUNK = 1000;
+        ArraySequence<int> chunk(CHUNK);
+        for (int i = 0; i < CHUNK; i++) chunk.Append(i);
+
+        auto measure = [&](const std::string& name, auto makeSequence) {
+            auto single = makeSequence();
+            auto bulk = makeSequence();
+            for (int i = 0; i < SIZE; i++) {
+                single->Append(i);
+                bulk->Append(i);
+            }
+
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < CHUNK; i++) single->InsertAt(chunk[i], SIZE / 2 + i);
+            for (int i = 0; i < CHUNK; i++) single->RemoveAt(SIZE / 4);
+            auto middle = std::chrono::high_resolution_clock::now();
+            bulk->InsertRange(SIZE / 2, chunk.Data(), chunk.Data() + CHUNK);
+            bulk->RemoveRange(SIZE / 4, CHUNK);
+            auto end = std::chrono::high_resolution_clock::now();
+
+            assertTrue(single->Get(SIZE / 2) == bulk->Get(SIZE / 2) && single->GetLength() == bulk->GetLength(), name + " range result");
+            std::cout << name << ": по одному " << std::chrono::duration_cast<std::chrono::microseconds>(middle - start).count()
+                      << "us, диапазоном " << std::chrono::duration_cast<std::chrono::microseconds>(end - middle).count() << "us" << std::endl;
+        };
+
+        std::cout << CHUNK << " элементов в середину и из середины " << SIZE << "-элементной последовательности" << std::endl;
+        measure("ArraySequence", [] { return std::make_shared<ArraySequence<int>>(); });
+        measure("LinkedListSequence", [] { return std::make_shared<LinkedListSequence<int>>(); });
+        measure("RingBufferSequence", [] { return std::make_shared<RingBufferSequence<int>>(); });
+        measure("Queue (ARRAY)", [] { return std::make_shared<Queue<int>>(Queue<int>::ARRAY); });
+    }
+
+    void testDoubleEndedPerformance() {
+        std::cout << "\n--- Prepend: ArraySequence, LinkedList, двусторонний массив ---" << std::endl;
+
+        const int COUNT = 100000;
+
+        auto measure = [&](const std::string& name, auto& seq) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < COUNT; i++) seq.Prepend(i);
+            auto filled = std::chrono::high_resolution_clock::now();
+            long long sum = 0;
+            for (int round = 0; round < 10; round++) {
+                for (int i = 0; i < seq.GetLength(); i++) sum += seq[i];
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << name << ": Prepend x" << COUNT << " "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(filled - start).count() << "ms, 10 обходов по индексу "
+                      << std::chrono::duration_cast<std::chrono::microseconds>(end - filled).count() << "us" << std::endl;
+            return sum;
+        };
+
+        ArraySequence<int> array;
+        DoubleEndedArraySequence<int> doubleEnded;
+        long long arraySum = measure("ArraySequence", array);
+        long long doubleEndedSum = measure("DoubleEndedArraySequence", doubleEnded);
+        assertEqual(doubleEndedSum, arraySum, "Prepend sum");
+
+        // Связный список обходится итерацией: доступ по индексу у него O(n)
+        auto start = std::chrono::high_resolution_clock::now();
+        LinkedListSequence<int> list;
+        for (int i = 0; i < COUNT; i++) list.Prepend(i);
+        auto end = std::chrono::high_resolution_clock::now();
+        std::cout << "LinkedListSequence: Prepend x" << COUNT << " "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+    }
+
+    void testPriorityPerformance() {
+        std::cout << "\n--- Приоритетная очередь: InsertAt против кучи ---" << std::endl;
+
+        const int COUNT = 20000;
+        auto keyOf = [](int i) { return static_cast<int>((static_cast<long long>(i) * 7919) % 100003); };
+
+        // Прежний способ: линейный поиск позиции и InsertAt
+        auto start = std::chrono::high_resolution_clock::now();
+        Queue<int> emulated(Queue<int>::RING);
+        for (int i = 0; i < COUNT; i++) {
+            int key = keyOf(i);
+            int position = 0;
+            while (position < emulated.GetLength() && emulated[position] <= key) position++;
+            emulated.InsertAt(key, position);
+        }
+        long long emulatedSum = 0;
+        while (!emulated.IsEmpty()) emulatedSum += emulated.Dequeue();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto emulatedTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        Queue<int> heap(Queue<int>::PRIORITY);
+        for (int i = 0; i < COUNT; i++) {
+            heap.Enqueue(keyOf(i));
+        }
+        long long heapSum = 0;
+        while (!heap.IsEmpty()) heapSum += heap.Dequeue();
+        end = std::chrono::high_resolution_clock::now();
+        auto heapTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        PairingHeap<int> pairing;
+        for (int i = 0; i < COUNT; i++) {
+            pairing.Enqueue(keyOf(i));
+        }
+        long long pairingSum = 0;
+        while (!pairing.IsEmpty()) pairingSum += pairing.Dequeue();
+        end = std::chrono::high_resolution_clock::now();
+        auto pairingTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        assertTrue(emulatedSum == heapSum && heapSum == pairingSum, "Priority sums");
+        std::cout << "InsertAt с линейным поиском, " << COUNT << " элементов: " << emulatedTime.count() << "us" << std::endl;
+        std::cout << "PRIORITY (" << HeapSequence<int>::ARITY << "-арная куча): " << heapTime.count() << "us" << std::endl;
+        std::cout << "PairingHeap: " << pairingTime.count() << "us" << std::endl;
+    }
+
+    void testDelayedPerformance() {
+        std::cout << "\n--- DelayedQueue против кучи таймеров ---" << std::endl;
+
+        using namespace std::chrono;
+        const int COUNT = 500000;
+        auto start = DelayedQueue<int>::Clock::now() + hours(1);
+        auto delayOf = [](int i) { return milliseconds(1 + (static_cast<long long>(i) * 7919) % 60000); };
+
+        auto begin = high_resolution_clock::now();
+        DelayedQueue<int> wheel(milliseconds(1), start);
+        std::vector<DelayedQueue<int>::Handle> handles(COUNT);
+        for (int i = 0; i < COUNT; i++) {
+            handles[i] = wheel.EnqueueAt(i, start + delayOf(i));
+        }
+        for (int i = 0; i < COUNT; i += 4) {
+            wheel.Cancel(handles[i]);
+        }
+        auto end = high_resolution_clock::now();
+        auto wheelInsertTime = duration_cast<microseconds>(end - begin);
+
+        begin = high_resolution_clock::now();
+        long long wheelSum = 0;
+        for (int ms = 0; ms <= 60010; ms += 10) {
+            wheel.Advance(start + milliseconds(ms));
+            int item;
+            while (wheel.GetLength() > 0 && wheel.TryDequeue(item)) wheelSum += item;
+        }
+        end = high_resolution_clock::now();
+        auto wheelDrainTime = duration_cast<microseconds>(end - begin);
+
+        // Куча таймеров: отмена — DecreaseKey к минимуму и извлечение
+        begin = high_resolution_clock::now();
+        PairingHeap<std::pair<long long, int>> heap;
+        std::vector<PairingHeap<std::pair<long long, int>>::Handle> heapHandles(COUNT);
+        for (int i = 0; i < COUNT; i++) {
+            heapHandles[i] = heap.Enqueue({delayOf(i).count(), i});
+        }
+        for (int i = 0; i < COUNT; i += 4) {
+            heap.DecreaseKey(heapHandles[i], {-1, i});
+            heap.Dequeue();
+        }
+        end = high_resolution_clock::now();
+        auto heapInsertTime = duration_cast<microseconds>(end - begin);
+
+        begin = high_resolution_clock::now();
+        long long heapSum = 0;
+        while (!heap.IsEmpty()) heapSum += heap.Dequeue().second;
+        end = high_resolution_clock::now();
+        auto heapDrainTime = duration_cast<microseconds>(end - begin);
+
+        assertEqual(wheelSum, heapSum, "Timer sums");
+        std::cout << "Колесо: вставка и отмена " << COUNT << " таймеров " << wheelInsertTime.count()
+                  << "us, истечение " << wheelDrainTime.count() << "us" << std::endl;
+        std::cout << "Парная куча: вставка и отмена " << heapInsertTime.count()
+                  << "us, истечение " << heapDrainTime.count() << "us" << std::endl;
+    }
+
+    void testSlidingWindowPerformance() {
+        std::cout << "\n--- Скользящее окно: Reduce против агрегата ---" << std::endl;
+
+        const int EVENTS = 20000;
+        const int WINDOW = 1000;
+        auto valueOf = [](int i) { return static_cast<double>((i * 7919) % 1000); };
+        auto maxOf = [](const double& a, const double& b) { return std::max(a, b); };
+        const double lowest = -std::numeric_limits<double>::infinity();
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Queue<double> queue(Queue<double>::RING);
+        double reduceCheck = 0;
+        for (int i = 0; i < EVENTS; i++) {
+            queue.Enqueue(valueOf(i));
+            if (queue.GetLength() > WINDOW) queue.Dequeue();
+            reduceCheck += queue.Reduce([](double a, double b) { return std::max(a, b); }, lowest);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto reduceTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        SlidingWindowQueue<double> window(maxOf, lowest, WINDOW);
+        double windowCheck = 0;
+        for (int i = 0; i < EVENTS; i++) {
+            window.Enqueue(valueOf(i));
+            windowCheck += window.GetAggregate();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto windowTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        SlidingWindowQueue<double> sums([](const double& a, const double& b) { return a + b; }, 0.0, WINDOW,
+                                        [](const double& total, const double& x) { return total - x; });
+        double sumCheck = 0;
+        for (int i = 0; i < EVENTS; i++) {
+            sums.Enqueue(valueOf(i));
+            sumCheck += sums.GetAggregate();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto sumTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        assertEqual(windowCheck, reduceCheck, "Window max sums");
+        std::cout << "Reduce после каждого Enqueue (max, окно " << WINDOW << "), " << EVENTS << " событий: "
+                  << reduceTime.count() << "us" << std::endl;
+        std::cout << "SlidingWindowQueue (две стопки, max): " << windowTime.count() << "us" << std::endl;
+        std::cout << "SlidingWindowQueue (обратимая сумма): " << sumTime.count() << "us, итог " << sumCheck << std::endl;
+    }
+
+#if LB3_QUEUE_METRICS
+    void testMetricsPerformance() {
+        std::cout << "\n--- Накладные расходы метрик очереди ---" << std::endl;
+
+        const int COUNT = 1000000;
+        const int BATCH = 100;
+        std::string report;
+
+        for (bool enabled : {false, true}) {
+            Queue<int> queue(Queue<int>::RING);
+            if (enabled) queue.EnableMetrics();
+
+            auto start = std::chrono::high_resolution_clock::now();
+            long long sum = 0;
+            for (int i = 0; i < COUNT; i += BATCH) {
+                for (int j = 0; j < BATCH; j++) queue.Enqueue(i + j);
+                for (int j = 0; j < BATCH; j++) sum += queue.Dequeue();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            auto time = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+            assertEqual(sum, static_cast<long long>(COUNT) * (COUNT - 1) / 2, "Metrics benchmark sum");
+            std::cout << "Enqueue/Dequeue x" << COUNT << (enabled ? " с метриками: " : " без метрик: ")
+                      << time.count() << "ms" << std::endl;
+            if (enabled) report = queue.GetMetrics().ToText();
+        }
+        std::cout << "Срез: " << report << std::endl;
+        std::cout << "Сборка с -DLB3_QUEUE_METRICS=0 убирает проверку полностью" << std::endl;
+    }
+#endif
+
+    void testAdaptivePerformance() {
+        std::cout << "\n--- ADAPTIVE при смене профиля нагрузки ---" << std::endl;
+
+        const int SIZE = 5000;
+        const int OPERATIONS = 20000;
+
+        for (auto type : {Queue<int>::ARRAY, Queue<int>::LINKED_LIST, Queue<int>::ADAPTIVE}) {
+            Queue<int> queue(type);
+            for (int i = 0; i < SIZE; i++) queue.Enqueue(i);
+
+            // Фаза 1: вставки в начало и удаление из конца; фаза 2: чтения по индексу
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < OPERATIONS; i++) {
+                queue.Prepend(i);
+                queue.RemoveAt(queue.GetLength() - 1);
+            }
+            auto middle = std::chrono::high_resolution_clock::now();
+            long long sum = 0;
+            for (int i = 0; i < OPERATIONS; i++) {
+                sum += queue[(i * 7919) % SIZE];
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+
+            auto prependTime = std::chrono::duration_cast<std::chrono::milliseconds>(middle - start);
+            auto readTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - middle);
+            assertTrue(sum > 0, "Adaptive benchmark sum");
+            std::cout << Queue<int>::StorageName(type) << ": Prepend-фаза " << prependTime.count()
+                      << "ms, чтения по индексу " << readTime.count() << "ms";
+            if (queue.IsAdaptive()) {
+                std::cout << ", переносов " << queue.GetMigrationLog().GetLength();
+                for (int i = 0; i < queue.GetMigrationLog().GetLength(); i++) {
+                    std::cout << "\n  " << queue.GetMigrationLog().Get(i);
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    template <typename QueueType>
+    static long long RunEnqueueDequeue(QueueType& queue, int rounds, int batch) {
+        long long sum = 0;
+        for (int r = 0; r < rounds; r++) {
+            for (int i = 0; i < batch; i++) queue.Enqueue(r + i);
+            for (int i = 0; i < batch; i++) sum += queue.Dequeue();
+        }
+        return sum;
+    }
+
+    void testStaticDispatchPerformance() {
+        std::cout << "\n--- Queue<T>: виртуальные вызовы против статических ---" << std::endl;
+
+        const int ROUNDS = 50000;
+        const int BATCH = 64;
+
+        auto measure = [&](auto& queue, long long& sum) {
+            auto start = std::chrono::high_resolution_clock::now();
+            sum = RunEnqueueDequeue(queue, ROUNDS, BATCH);
+            auto end = std::chrono::high_resolution_clock::now();
+            return std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        };
+
+        long long dynamicSum = 0, staticSum = 0;
+        Queue<int> dynamicRing(Queue<int>::RING);
+        Queue<int, RingStorage> staticRing;
+        auto dynamicTime = measure(dynamicRing, dynamicSum);
+        auto staticTime = measure(staticRing, staticSum);
+        assertEqual(dynamicSum, staticSum, "Static dispatch sum");
+        std::cout << "RING: Queue<T> " << dynamicTime << "us, Queue<T, RingStorage> " << staticTime << "us" << std::endl;
+
+        Queue<int> dynamicArray(Queue<int>::ARRAY);
+        Queue<int, ArrayStorage> staticArray;
+        dynamicTime = measure(dynamicArray, dynamicSum);
+        staticTime = measure(staticArray, staticSum);
+        assertEqual(dynamicSum, staticSum, "Static dispatch sum");
+        std::cout << "ARRAY: Queue<T> " << dynamicTime << "us, Queue<T, ArrayStorage> " << staticTime << "us" << std::endl;
+
+        Queue<int> dynamicList(Queue<int>::LINKED_LIST);
+        Queue<int, LinkedListStorage> staticList;
+        dynamicTime = measure(dynamicList, dynamicSum);
+        staticTime = measure(staticList, staticSum);
+        assertEqual(dynamicSum, staticSum, "Static dispatch sum");
+        std::cout << "LINKED_LIST: Queue<T> " << dynamicTime << "us, Queue<T, LinkedListStorage> " << staticTime << "us" << std::endl;
+    }
+
+    void testSpillPerformance() {
+        std::cout << "\n--- SpillQueue: бюджет памяти против Queue ---" << std::endl;
+
+        const int COUNT = 2000000;
+        const std::size_t budget = 1 << 20;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Queue<int> queue(Queue<int>::RING);
+        for (int i = 0; i < COUNT; i++) queue.Enqueue(i);
+        long long queueSum = 0;
+        while (!queue.IsEmpty()) queueSum += queue.Dequeue();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto queueTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        SpillQueue<int> spill(budget, 16384);
+        std::size_t peak = 0;
+        for (int i = 0; i < COUNT; i++) {
+            spill.Enqueue(i);
+            peak = std::max(peak, spill.GetMemoryBytes());
+        }
+        long long spillSum = 0;
+        while (!spill.IsEmpty()) spillSum += spill.Dequeue();
+        end = std::chrono::high_resolution_clock::now();
+        auto spillTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        assertEqual(spillSum, queueSum, "Spill sum");
+        std::cout << "Queue (RING), " << COUNT << " int, ~" << COUNT * sizeof(int) / 1024 << " КиБ в памяти: "
+                  << queueTime.count() << "ms" << std::endl;
+        std::cout << "SpillQueue, бюджет " << budget / 1024 << " КиБ, пик " << peak / 1024 << " КиБ, выгрузок "
+                  << spill.GetSpillCount() << ": " << spillTime.count() << "ms" << std::endl;
+    }
+
+    void testSpscPerformance() {
+        std::cout << "\n--- Производительность SpscQueue против Queue + mutex ---" << std::endl;
+
+        const int COUNT = 1000000;
+        const int ROUND_TRIPS = 20000;
+
+        // Queue<int> под мьютексом — то, чем пользовались до SpscQueue
+        struct LockedQueue {
+            std::mutex mutex;
+            Queue<int> queue;
+
+            LockedQueue() : queue(Queue<int>::RING) {}
+
+            bool TryEnqueue(int item) {
+                std::lock_guard<std::mutex> lock(mutex);
+                queue.Enqueue(item);
+                return true;
+            }
+
+            bool TryDequeue(int& out) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (queue.IsEmpty()) return false;
+                out = queue.Dequeue();
+                return true;
+            }
+        };
+
+        auto throughput = [&](auto& queue) {
+            auto start = std::chrono::high_resolution_clock::now();
+            std::thread producer([&]() {
+                for (int i = 0; i < COUNT; i++) {
+                    while (!queue.TryEnqueue(i)) std::this_thread::yield();
+                }
+            });
+            long long sum = 0;
+            int item;
+            for (int i = 0; i < COUNT; i++) {
+                while (!queue.TryDequeue(item)) std::this_thread::yield();
+                sum += item;
+            }
+            producer.join();
+            auto end = std::chrono::high_resolution_clock::now();
+            assertEqual(sum, 1LL * COUNT * (COUNT - 1) / 2, "Benchmark sum");
+            return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        };
+
+        // Пинг-понг через пару очередей: время полного круга
+        auto roundTrip = [&](auto& ping, auto& pong) {
+            std::thread echo([&]() {
+                int item;
+                for (int i = 0; i < ROUND_TRIPS; i++) {
+                    while (!ping.TryDequeue(item)) std::this_thread::yield();
+                    while (!pong.TryEnqueue(item)) std::this_thread::yield();
+                }
+            });
+            auto start = std::chrono::high_resolution_clock::now();
+            int item;
+            for (int i = 0; i < ROUND_TRIPS; i++) {
+                while (!ping.TryEnqueue(i)) std::this_thread::yield();
+                while (!pong.TryDequeue(item)) std::this_thread::yield();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            echo.join();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / ROUND_TRIPS;
+        };
+
+        SpscQueue<int> spsc(1024);
+        LockedQueue locked;
+        std::cout << "SpscQueue, " << COUNT << " элементов: " << throughput(spsc) << "ms" << std::endl;
+        std::cout << "Queue + mutex, " << COUNT << " элементов: " << throughput(locked) << "ms" << std::endl;
+
+        SpscQueue<int> spscPing(1024), spscPong(1024);
+        LockedQueue lockedPing, lockedPong;
+        std::cout << "SpscQueue круг: " << roundTrip(spscPing, spscPong) << "ns" << std::endl;
+        std::cout << "Queue + mutex круг: " << roundTrip(lockedPing, lockedPong) << "ns" << std::endl;
+    }
+
+    void testMpmcPerformance() {
+        std::cout << "\n--- Масштабирование MpmcQueue ---" << std::endl;
+
+        const int TOTAL = 400000;
+        const int BATCH = 32;
+        int maxThreads = std::max(16, static_cast<int>(std::thread::hardware_concurrency()));
+
+        // threads производителей и столько же потребителей делят TOTAL элементов
+        auto run = [&](int threads, int batch) {
+            MpmcQueue<int> queue(4096);
+            int perThread = TOTAL / threads;
+            std::atomic<long long> sum{0};
+            std::vector<std::thread> workers;
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int t = 0; t < threads; t++) {
+                workers.emplace_back([&]() {
+                    std::vector<int> items(batch, 1);
+                    for (int sent = 0; sent < perThread;) {
+                        int n = queue.TryEnqueueN(items.data(), std::min(batch, perThread - sent));
+                        if (n == 0) std::this_thread::yield();
+                        sent += n;
+                    }
+                });
+                workers.emplace_back([&]() {
+                    std::vector<int> items(batch);
+                    long long local = 0;
+                    for (int received = 0; received < perThread;) {
+                        int n = queue.TryDequeueN(items.data(), std::min(batch, perThread - received));
+                        if (n == 0) std::this_thread::yield();
+                        for (int i = 0; i < n; i++) local += items[i];
+                        received += n;
+                    }
+                    sum += local;
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            assertEqual(sum.load(), 1LL * perThread * threads, "Scaling sum");
+            return std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        };
+
+        for (int threads = 1; threads <= maxThreads; threads *= 2) {
+            auto single = run(threads, 1);
+            auto batched = run(threads, BATCH);
+            std::cout << threads << "x" << threads << " потоков: по одному " << single
+                      << "ms, пакетами по " << BATCH << " " << batched << "ms" << std::endl;
+        }
+    }
+
+    void testBroadcastPerformance() {
+        std::cout << "\n--- BroadcastQueue против копий в N очередей ---" << std::endl;
+
+        const int COUNT = 200000;
+        const int CONSUMERS = 4;
+        const std::string payload(48, 'x');
+
+        // Прежний способ: производитель копирует каждый элемент в очередь каждого подписчика
+        std::vector<std::unique_ptr<SpscQueue<std::string>>> copies;
+        for (int c = 0; c < CONSUMERS; c++) copies.push_back(std::make_unique<SpscQueue<std::string>>(1024));
+        std::vector<long long> copyBytes(CONSUMERS, 0);
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (int c = 0; c < CONSUMERS; c++) {
+            threads.emplace_back([&, c]() {
+                for (int i = 0; i < COUNT; i++) copyBytes[c] += copies[c]->Dequeue().size();
+            });
+        }
+        for (int i = 0; i < COUNT; i++) {
+            for (int c = 0; c < CONSUMERS; c++) copies[c]->Enqueue(payload);
+        }
+        for (auto& thread : threads) thread.join();
+        auto end = std::chrono::high_resolution_clock::now();
+        auto copyTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        BroadcastQueue<std::string> ring(1024);
+        std::vector<BroadcastQueue<std::string>::Consumer> consumers;
+        for (int c = 0; c < CONSUMERS; c++) consumers.push_back(ring.Subscribe());
+        std::vector<long long> ringBytes(CONSUMERS, 0);
+        threads.clear();
+        start = std::chrono::high_resolution_clock::now();
+        for (int c = 0; c < CONSUMERS; c++) {
+            threads.emplace_back([&, c]() {
+                int seen = 0;
+                while (seen < COUNT) {
+                    auto batch = consumers[c].ReadBatch(256);
+                    if (batch.size == 0) {
+                        std::this_thread::yield();
+                        continue;
+                    }
+                    for (const std::string& item : batch) ringBytes[c] += item.size();
+                    seen += batch.size;
+                    consumers[c].Commit();
+                }
+            });
+        }
+        for (int i = 0; i < COUNT; i++) {
+            ring.Enqueue(payload);
+        }
+        for (auto& thread : threads) thread.join();
+        end = std::chrono::high_resolution_clock::now();
+        auto ringTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        assertTrue(copyBytes == ringBytes, "Broadcast bytes");
+        std::cout << CONSUMERS << " копии в SpscQueue, " << COUNT << " строк: " << copyTime.count() << "ms" << std::endl;
+        std::cout << "BroadcastQueue, одна запись на элемент: " << ringTime.count() << "ms" << std::endl;
+    }
+
+    void testPipelinePerformance() {
+        std::cout << "\n--- Конвейер против последовательных Map/Where ---" << std::endl;
+
+        const int COUNT = 200000;
+        auto heavy = [](double x) {
+            for (int i = 0; i < 20; i++) x = std::sin(x) + 1.0;
+            return x;
+        };
+        auto keep = [](double x) { return static_cast<long long>(x * 1e9) % 2 == 0; };
+
+        Queue<double> queue(Queue<double>::RING);
+        for (int i = 0; i < COUNT; i++) queue.Enqueue(i * 0.001);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        auto mapped = queue.Map(heavy);
+        auto filtered = mapped->Where(keep);
+        double sequentialSum = filtered->Reduce([](double a, double b) { return a + b; }, 0.0);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto sequentialTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        double pipelineSum = 0;
+        Pipeline<double> pipeline(1024, 64);
+        pipeline.Source(queue).Map(heavy, "Heavy").Where(keep, "Keep")
+                .Sink([&pipelineSum](const double& x) { pipelineSum += x; });
+        pipeline.Run();
+        end = std::chrono::high_resolution_clock::now();
+        auto pipelineTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        assertTrue(std::abs(sequentialSum - pipelineSum) < 1e-6 * std::abs(sequentialSum), "Pipeline sum");
+        std::cout << "Последовательно Map -> Where -> Reduce, " << COUNT << " элементов: " << sequentialTime.count() << "ms" << std::endl;
+        std::cout << "Pipeline (" << std::thread::hardware_concurrency() << " ядер): " << pipelineTime.count() << "ms" << std::endl;
+        std::cout << pipeline.MetricsReport() << std::endl;
+    }
+
+    void testPoolPerformance() {
+        std::cout << "\n--- Производительность WorkStealingPool ---" << std::endl;
+
+        const int SEQUENCES = 64;
+        const int LENGTH = 20000;
+        std::vector<ArraySequence<int>> sequences(SEQUENCES);
+        for (auto& seq : sequences) {
+            for (int i = 0; i < LENGTH; i++) {
+                seq.Append(i % 1000);
+            }
+        }
+
+        auto job = [&](int index) {
+            auto mapped = sequences[index].Map([](int x) { return x * 3; });
+            auto filtered = mapped->Where([](int x) { return x % 2 == 0; });
+            return filtered->Reduce([](int a, int b) { return a + b; }, 0);
+        };
+
+        std::vector<int> sequentialResults(SEQUENCES);
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < SEQUENCES; i++) {
+            sequentialResults[i] = job(i);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto sequentialTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        WorkStealingPool pool;
+        std::vector<int> parallelResults(SEQUENCES);
+        start = std::chrono::high_resolution_clock::now();
+        pool.ParallelFor(0, SEQUENCES, [&](int i) { parallelResults[i] = job(i); }, 1);
+        end = std::chrono::high_resolution_clock::now();
+        auto parallelTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        assertTrue(parallelResults == sequentialResults, "ParallelFor Map/Where/Reduce");
+        std::cout << "Последовательно: " << sequentialTime.count() << "ms" << std::endl;
+        std::cout << "WorkStealingPool (" << pool.GetThreadCount() << " потоков): "
+                  << parallelTime.count() << "ms" << std::endl;
+        std::cout << "Краж: " << pool.GetStealCount() << ", простой: "
+                  << pool.GetIdleTime().count() / 1000 << "ms" << std::endl;
+    }
+
+#if defined(__cpp_impl_coroutine)
+    void testCoroutinePerformance() {
+        std::cout << "\n--- Корутины против потока на потребителя ---" << std::endl;
+
+        const int CONSUMERS = 1000;
+        const int ITEMS_PER_CONSUMER = 20;
+        const int TOTAL = CONSUMERS * ITEMS_PER_CONSUMER;
+        const long long EXPECTED = 1LL * TOTAL * (TOTAL - 1) / 2;
+
+        auto start = std::chrono::high_resolution_clock::now();
+        {
+            WorkStealingPool executor(2);
+            AsyncQueue<int> queue(executor);
+            std::atomic<long long> sum{0};
+            std::atomic<int> finished{0};
+            for (int i = 0; i < CONSUMERS; i++) {
+                consumeAsync(queue, ITEMS_PER_CONSUMER, sum, finished);
+            }
+            for (int i = 0; i < TOTAL; i++) {
+                queue.Enqueue(i);
+            }
+            executor.Wait();
+            assertEqual(sum.load(), EXPECTED, "Coroutine consumers sum");
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto coroutineTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        {
+            BlockingQueue<int> queue;
+            std::atomic<long long> sum{0};
+            std::vector<std::thread> consumers;
+            for (int i = 0; i < CONSUMERS; i++) {
+                consumers.emplace_back([&]() {
+                    for (int j = 0; j < ITEMS_PER_CONSUMER; j++) {
+                        sum += queue.Dequeue();
+                    }
+                });
+            }
+            for (int i = 0; i < TOTAL; i++) {
+                queue.Enqueue(i);
+            }
+            for (auto& consumer : consumers) {
+                consumer.join();
+            }
+            assertEqual(sum.load(), EXPECTED, "Thread consumers sum");
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto threadTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        std::cout << CONSUMERS << " корутин: " << coroutineTime.count() << "ms" << std::endl;
+        std::cout << CONSUMERS << " потоков: " << threadTime.count() << "ms" << std::endl;
+    }
+#endif
+
+#if defined(__linux__)
+    void testSharedMemoryPerformance() {
+        std::cout << "\n--- SharedMemoryQueue между процессами ---" << std::endl;
+
+        const int COUNT = 200000;
+        const int ROUND_TRIPS = 10000;
+        const std::string requests = "/lb3_queue_bench_req_" + std::to_string(getpid());
+        const std::string replies = "/lb3_queue_bench_rep_" + std::to_string(getpid());
+        SharedMemoryQueue<int>::Unlink(requests);
+        SharedMemoryQueue<int>::Unlink(replies);
+        SharedMemoryQueue<int> requestQueue(requests, 4096);
+        SharedMemoryQueue<int> replyQueue(replies, 4096);
+
+        std::cout.flush();
+        pid_t child = fork();
+        if (child == 0) {
+            // Второй процесс открывает сегменты по имени, как это делал бы независимый процесс
+            int status = 0;
+            try {
+                SharedMemoryQueue<int> in(requests);
+                SharedMemoryQueue<int> out(replies);
+                long long sum = 0;
+                for (int i = 0; i < COUNT; i++) {
+                    sum += in.Dequeue();
+                }
+                status = (sum == 1LL * COUNT * (COUNT - 1) / 2) ? 0 : 1;
+                for (int i = 0; i < ROUND_TRIPS; i++) {
+                    out.Enqueue(in.Dequeue());
+                }
+            } catch (...) {
+                status = 2;
+            }
+            _exit(status);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < COUNT; i++) {
+            requestQueue.Enqueue(i);
+        }
+        while (!requestQueue.IsEmpty()) {
+            std::this_thread::yield();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto transferTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < ROUND_TRIPS; i++) {
+            requestQueue.Enqueue(i);
+            replyQueue.Dequeue();
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto roundTrip = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() / ROUND_TRIPS;
+
+        int status = 0;
+        waitpid(child, &status, 0);
+        assertTrue(WIFEXITED(status) && WEXITSTATUS(status) == 0, "Второй процесс получил все элементы");
+        SharedMemoryQueue<int>::Unlink(requests);
+        SharedMemoryQueue<int>::Unlink(replies);
+
+        // Прежний путь: Serialize в файл и Deserialize из него
+        const std::string filename = "/tmp/lb3_queue_bench_" + std::to_string(getpid()) + ".txt";
+        Queue<int> source(Queue<int>::RING);
+        for (int i = 0; i < COUNT; i++) {
+            source.Enqueue(i);
+        }
+        start = std::chrono::high_resolution_clock::now();
+        source.Serialize(filename);
+        Queue<int> loaded(Queue<int>::RING);
+        loaded.Deserialize(filename);
+        end = std::chrono::high_resolution_clock::now();
+        auto fileTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+        std::remove(filename.c_str());
+
+        std::cout << "Shared memory, " << COUNT << " элементов: " << transferTime.count() << "ms" << std::endl;
+        std::cout << "Shared memory круг между процессами: " << roundTrip << "ns" << std::endl;
+        std::cout << "Через файл, " << COUNT << " элементов: " << fileTime.count() << "ms" << std::endl;
+    }
+
+    void testPersistentPerformance() {
+        std::cout << "\n--- Групповая фиксация PersistentQueue ---" << std::endl;
+
+        const int COUNT = 2000;
+        const std::string directory = "/tmp/lb3_persistent_bench_" + std::to_string(getpid());
+
+        auto run = [&](PersistentQueueOptions options, const std::string& label) {
+            std::filesystem::remove_all(directory);
+            auto start = std::chrono::high_resolution_clock::now();
+            {
+                PersistentQueue<int> queue(directory, options);
+                for (int i = 0; i < COUNT; i++) {
+                    queue.Enqueue(i);
+                }
+                long long sum = 0;
+                while (!queue.IsEmpty()) {
+                    sum += queue.Dequeue();
+                }
+                assertEqual(sum, 1LL * COUNT * (COUNT - 1) / 2, "Persistent sum");
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << label << ": " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                      << "ms" << std::endl;
+        };
+
+        PersistentQueueOptions everyRecord;
+        PersistentQueueOptions grouped;
+        grouped.syncEveryRecords = 256;
+        PersistentQueueOptions timed;
+        timed.syncEveryRecords = 0;
+        timed.syncInterval = std::chrono::milliseconds(5);
+
+        run(everyRecord, "fsync на каждую запись, " + std::to_string(COUNT));
+        run(grouped, "fsync на 256 записей, " + std::to_string(COUNT));
+        run(timed, "fsync раз в 5ms, " + std::to_string(COUNT));
+        std::filesystem::remove_all(directory);
+    }
+
+    void testSnapshotPerformance() {
+        std::cout << "\n--- Текстовый Serialize против двоичного снимка ---" << std::endl;
+
+        const int COUNT = 200000;
+        const std::string textFile = "/tmp/lb3_snapshot_bench_" + std::to_string(getpid()) + ".txt";
+        const std::string binaryFile = "/tmp/lb3_snapshot_bench_" + std::to_string(getpid()) + ".bin";
+
+        ArraySequence<double> values;
+        Queue<double> queue(Queue<double>::RING);
+        for (int i = 0; i < COUNT; i++) {
+            values.Append(i * 0.5);
+            queue.Enqueue(i * 0.5);
+        }
+        queue.Serialize(textFile);
+        values.SerializeBinary(binaryFile);
+
+        auto start = std::chrono::high_resolution_clock::now();
+        Queue<double> fromText(Queue<double>::RING);
+        fromText.Deserialize(textFile);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto textTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        ArraySequence<double> fromBinary;
+        fromBinary.DeserializeBinary(binaryFile);
+        end = std::chrono::high_resolution_clock::now();
+        auto binaryTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        double sum = 0;
+        {
+            SnapshotView<double> view(binaryFile);
+            for (int i = 0; i < view.GetLength(); i++) {
+                sum += view.Data()[i];
+            }
+        }
+        end = std::chrono::high_resolution_clock::now();
+        auto viewTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        assertEqual(fromBinary.GetLength(), COUNT, "Binary snapshot length");
+        assertEqual(sum, 0.5 * COUNT * (COUNT - 1) / 2, "Snapshot view sum");
+        std::cout << "Deserialize (текст), " << COUNT << " double: " << textTime.count() << "us" << std::endl;
+        std::cout << "DeserializeBinary, " << COUNT << " double: " << binaryTime.count() << "us" << std::endl;
+        std::cout << "SnapshotView без копирования: " << viewTime.count() << "us" << std::endl;
+        std::remove(textFile.c_str());
+        std::remove(binaryFile.c_str());
+    }
+
+    void testAsyncSerializationPerformance() {
+        std::cout << "\n--- Асинхронная сериализация ---" << std::endl;
+
+        const int COUNT = 1000000;
+        const std::string textFile = "/tmp/lb3_async_bench_" + std::to_string(getpid()) + ".txt";
+        const std::string binaryFile = "/tmp/lb3_async_bench_" + std::to_string(getpid()) + ".bin";
+        std::cout << "Бэкенд: " << (IoUring::IsSupported() ? "io_uring" : "пул потоков + pwrite") << std::endl;
+
+        Queue<double> queue(Queue<double>::RING);
+        for (int i = 0; i < COUNT; i++) {
+            queue.Enqueue(i * 0.5);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        queue.Serialize(textFile);
+        auto end = std::chrono::high_resolution_clock::now();
+        auto textTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        std::future<std::uint64_t> written = SerializeBinaryAsync(queue, binaryFile);
+        end = std::chrono::high_resolution_clock::now();
+        auto blockedTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        written.get();
+        end = std::chrono::high_resolution_clock::now();
+        auto totalTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        Queue<double> fromText(Queue<double>::RING);
+        fromText.Deserialize(textFile);
+        end = std::chrono::high_resolution_clock::now();
+        auto textReadTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        start = std::chrono::high_resolution_clock::now();
+        ArraySequence<double> fromBinary;
+        DeserializeBinaryReadAhead(binaryFile, fromBinary);
+        end = std::chrono::high_resolution_clock::now();
+        auto readAheadTime = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+
+        assertEqual(fromBinary.GetLength(), COUNT, "Read-ahead length");
+        std::cout << "Serialize (текст), поток заблокирован: " << textTime.count() << "us" << std::endl;
+        std::cout << "SerializeBinaryAsync, поток заблокирован: " << blockedTime.count()
+                  << "us, до готовности future: " << totalTime.count() << "us" << std::endl;
+        std::cout << "Deserialize (текст): " << textReadTime.count() << "us" << std::endl;
+        std::cout << "DeserializeBinaryReadAhead: " << readAheadTime.count() << "us" << std::endl;
+        std::remove(textFile.c_str());
+        std::remove(binaryFile.c_str());
+    }
+
+    void testMappedGrowthPerformance() {
+        std::cout << "\n--- Рост ArraySequence<double>: mremap против копирования ---" << std::endl;
+
+        const int COUNT = 32 * 1024 * 1024;
+
+        // Пик считается по буферам: копирующий рост держит старый и новый одновременно
+        auto run = [&](auto tag) {
+            using Item = decltype(tag);
+            std::size_t peak = 0;
+            auto start = std::chrono::high_resolution_clock::now();
+            ArraySequence<Item> seq;
+            int capacity = seq.GetCapacity();
+            bool wasMapped = false;
+            for (int i = 0; i < COUNT; i++) {
+                seq.Append(Item(i));
+                if (seq.GetCapacity() != capacity) {
+                    std::size_t held = (wasMapped && seq.IsMapped()) ? 0 : capacity * sizeof(Item);
+                    peak = std::max(peak, held + seq.GetCapacity() * sizeof(Item));
+                    capacity = seq.GetCapacity();
+                    wasMapped = seq.IsMapped();
+                }
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            std::cout << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms, пик буферов "
+                      << peak / (1024 * 1024) << " МиБ" << std::endl;
+            return seq.GetLast() == Item(COUNT - 1);
+        };
+
+        std::cout << COUNT << " элементов (" << COUNT * sizeof(double) / (1024 * 1024) << " МиБ)" << std::endl;
+        std::cout << "mremap: ";
+        bool mapped = run(double());
+        std::cout << "Поэлементное копирование: ";
+        bool copied = run(OpaqueValue<double>());
+        assertTrue(mapped && copied, "Mapped growth");
     }
+#endif
 
     void printResults() {
         std::cout << "\n=== ИТОГИ ТЕСТИРОВАНИЯ ===" << std::endl;
@@ -1242,13 +9419,20 @@ private:
     template<typename T>
     void demoQueueOperations() {
         int storageChoice;
-        std::cout << "Выберите тип хранения:\n1. Массив\n2. Связный список\nВыбор: ";
+        std::cout << "Выберите тип хранения:\n1. Массив\n2. Связный список\n3. Кольцевой буфер\n4. Приоритетная куча\n5. Адаптивное\nВыбор: ";
         std::cin >> storageChoice;
         
-        typename Queue<T>::StorageType storageType = (storageChoice == 1) ? 
-            Queue<T>::ARRAY : Queue<T>::LINKED_LIST;
+        typename Queue<T>::StorageType storageType = (storageChoice == 1) ? Queue<T>::ARRAY :
+            (storageChoice == 3) ? Queue<T>::RING :
+            (storageChoice == 4) ? Queue<T>::PRIORITY :
+            (storageChoice == 5) ? Queue<T>::ADAPTIVE : Queue<T>::LINKED_LIST;
         
         Queue<T> queue(storageType);
+        if (queue.IsAdaptive()) {
+            queue.SetMigrationLogger([](const std::string& message) {
+                std::cout << "[ADAPTIVE] " << message << std::endl;
+            });
+        }
         int choice;
         
         do {
@@ -1377,6 +9561,28 @@ private:
         
         TestRunner runner;
         runner.testPerformance();
+        runner.testArrayStoragePerformance();
+        runner.testSmallArrayPerformance();
+        runner.testTrivialRelocationPerformance();
+        runner.testRangePerformance();
+        runner.testDoubleEndedPerformance();
+        runner.testPriorityPerformance();
+        runner.testDelayedPerformance();
+        runner.testSlidingWindowPerformance();
+        runner.testAdaptivePerformance();
+        runner.testStaticDispatchPerformance();
+        runner.testSpillPerformance();
+#if LB3_QUEUE_METRICS
+        runner.testMetricsPerformance();
+#endif
+        runner.testSpscPerformance();
+        runner.testMpmcPerformance();
+        runner.testBroadcastPerformance();
+        runner.testPipelinePerformance();
+        runner.testPoolPerformance();
+#if defined(__cpp_impl_coroutine)
+        runner.testCoroutinePerformance();
+#endif
     }
 
 public:
@@ -1407,7 +9613,38 @@ public:
                 case 4:
                     std::cout << "\n=== ИНФОРМАЦИЯ О РЕАЛИЗАЦИИ ===" << std::endl;
                     std::cout << "АТД Динамический массив: ✓" << std::endl;
+                    std::cout << "Динамический массив на сыром буфере (Emplace, Reserve, перемещение): ✓" << std::endl;
+                    std::cout << "Оптимизация малого буфера (SmallArraySequence): ✓" << std::endl;
+                    std::cout << "Побайтовый перенос тривиально копируемых элементов (memmove, realloc): ✓" << std::endl;
+                    std::cout << "Групповые операции AppendRange, InsertRange, RemoveRange: ✓" << std::endl;
                     std::cout << "АТД Связный список: ✓" << std::endl;
+                    std::cout << "АТД Кольцевой буфер: ✓" << std::endl;
+                    std::cout << "Двусторонний массив с Prepend за O(1): ✓" << std::endl;
+                    std::cout << "Приоритетная очередь (d-арная куча, парная куча): ✓" << std::endl;
+                    std::cout << "Очередь с задержкой на иерархическом колесе таймеров: ✓" << std::endl;
+                    std::cout << "Агрегат скользящего окна за O(1): ✓" << std::endl;
+                    std::cout << "Адаптивное хранилище очереди (ADAPTIVE): ✓" << std::endl;
+                    std::cout << "Очередь со статической диспетчеризацией Queue<T, StoragePolicy>: ✓" << std::endl;
+                    std::cout << "Очередь с выгрузкой на диск при нехватке памяти: ✓" << std::endl;
+#if LB3_QUEUE_METRICS
+                    std::cout << "Метрики очереди (время пребывания, глубина): ✓" << std::endl;
+#endif
+                    std::cout << "Очередь SPSC без блокировок: ✓" << std::endl;
+                    std::cout << "Очередь MPMC без блокировок: ✓" << std::endl;
+                    std::cout << "Широковещательное кольцо с курсорами подписчиков: ✓" << std::endl;
+                    std::cout << "Блокирующая очередь с backpressure: ✓" << std::endl;
+                    std::cout << "Многостадийный конвейер (Pipeline): ✓" << std::endl;
+                    std::cout << "Пул потоков с кражей работы: ✓" << std::endl;
+#if defined(__cpp_impl_coroutine)
+                    std::cout << "Очередь для корутин (co_await): ✓" << std::endl;
+#endif
+#if defined(__linux__)
+                    std::cout << "Очередь в разделяемой памяти: ✓" << std::endl;
+                    std::cout << "Персистентная очередь на сегментах журнала: ✓" << std::endl;
+                    std::cout << "Двоичные снимки с загрузкой через mmap: ✓" << std::endl;
+                    std::cout << "Асинхронная запись (io_uring) и чтение с опережением: ✓" << std::endl;
+                    std::cout << "Рост больших массивов через mremap: ✓" << std::endl;
+#endif
                     std::cout << "АТД Последовательность: ✓" << std::endl;
                     std::cout << "АТД Очередь: ✓" << std::endl;
                     std::cout << "Поддержка типов: int, double, Complex, string, Person, FunctionPtr" << std::endl;
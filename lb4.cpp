@@ -7,6 +7,13 @@
 #include <string>
 #include <sstream>
 #include <type_traits>
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <chrono>
+#include <complex>
 
 // ==================== ИСКЛЮЧЕНИЯ ====================
 class IndexOutOfRange : public std::out_of_range {
@@ -88,13 +95,44 @@ private:
     int size;
     int capacity;
 
+    // Тривиально копируемые элементы переносятся побайтно: realloc при росте, memmove при сдвигах
+    static constexpr bool TRIVIAL_RELOCATION = std::is_trivially_copyable_v<T> && alignof(T) <= alignof(std::max_align_t);
+
+    static T* allocate(int count) {
+        if constexpr (TRIVIAL_RELOCATION) {
+            T* memory = static_cast<T*>(std::malloc(sizeof(T) * std::max(count, 1)));
+            if (memory == nullptr) throw std::bad_alloc();
+            std::uninitialized_default_construct(memory, memory + count);
+            return memory;
+        } else {
+            return new T[count];
+        }
+    }
+
+    static void release(T* memory) {
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::free(memory);
+        } else {
+            delete[] memory;
+        }
+    }
+
     void resize(int newCapacity) {
-        T* newItems = new T[newCapacity];
-        for (int i = 0; i < size; i++) {
-            newItems[i] = items[i];
+        if constexpr (TRIVIAL_RELOCATION) {
+            T* newItems = static_cast<T*>(std::realloc(items, sizeof(T) * std::max(newCapacity, 1)));
+            if (newItems == nullptr) throw std::bad_alloc();
+            if (newCapacity > capacity) {
+                std::uninitialized_default_construct(newItems + capacity, newItems + newCapacity);
+            }
+            items = newItems;
+        } else {
+            T* newItems = new T[newCapacity];
+            for (int i = 0; i < size; i++) {
+                newItems[i] = std::move(items[i]);
+            }
+            delete[] items;
+            items = newItems;
         }
-        delete[] items;
-        items = newItems;
         capacity = newCapacity;
     }
 
@@ -122,31 +160,31 @@ public:
     };
 
     DynamicArray() : size(0), capacity(10) {
-        items = new T[capacity];
+        items = allocate(capacity);
     }
 
     DynamicArray(int size) : size(size), capacity(size * 2 + 1) {
         if (size < 0) throw std::invalid_argument("Size cannot be negative");
-        items = new T[capacity];
+        items = allocate(capacity);
     }
 
     DynamicArray(T* items, int count) : size(count), capacity(count * 2 + 1) {
         if (count < 0) throw std::invalid_argument("Count cannot be negative");
-        this->items = new T[capacity];
+        this->items = allocate(capacity);
         for (int i = 0; i < count; i++) {
             this->items[i] = items[i];
         }
     }
 
     DynamicArray(const DynamicArray<T>& other) : size(other.size), capacity(other.capacity) {
-        items = new T[capacity];
+        items = allocate(capacity);
         for (int i = 0; i < size; i++) {
             items[i] = other.items[i];
         }
     }
 
     DynamicArray(std::initializer_list<T> initList) : size(initList.size()), capacity(initList.size() * 2 + 1) {
-        items = new T[capacity];
+        items = allocate(capacity);
         int i = 0;
         for (const auto& item : initList) {
             items[i++] = item;
@@ -154,7 +192,7 @@ public:
     }
 
     ~DynamicArray() {
-        delete[] items;
+        release(items);
     }
 
     std::unique_ptr<IIterator<T>> CreateIterator() const override {
@@ -202,8 +240,12 @@ public:
             resize(capacity * 2);
         }
         
-        for (int i = size; i > index; i--) {
-            items[i] = items[i - 1];
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::memmove(static_cast<void*>(items + index + 1), static_cast<const void*>(items + index), sizeof(T) * (size - index));
+        } else {
+            for (int i = size; i > index; i--) {
+                items[i] = std::move(items[i - 1]);
+            }
         }
         items[index] = item;
         size++;
@@ -213,8 +255,12 @@ public:
         if (index < 0 || index >= size) throw IndexOutOfRange();
         
         T removed = items[index];
-        for (int i = index; i < size - 1; i++) {
-            items[i] = items[i + 1];
+        if constexpr (TRIVIAL_RELOCATION) {
+            std::memmove(static_cast<void*>(items + index), static_cast<const void*>(items + index + 1), sizeof(T) * (size - index - 1));
+        } else {
+            for (int i = index; i < size - 1; i++) {
+                items[i] = std::move(items[i + 1]);
+            }
         }
         size--;
         
@@ -986,6 +1032,47 @@ void DemoSlice() {
     delete negativeSlice;
 }
 
+// Обёртка с пользовательским копированием: отключает побайтовый перенос для сравнения
+template <class T>
+struct OpaqueValue {
+    T value;
+
+    OpaqueValue() : value() {}
+    OpaqueValue(T item) : value(item) {}
+    OpaqueValue(const OpaqueValue& other) : value(other.value) {}
+    OpaqueValue& operator=(const OpaqueValue& other) { value = other.value; return *this; }
+};
+
+template <class T>
+void MeasureDynamicArray(const std::string& name, int count, int shifts) {
+    auto start = std::chrono::high_resolution_clock::now();
+    DynamicArray<T> array;
+    for (int i = 0; i < count; i++) {
+        array.Append(T(i));
+    }
+    auto grown = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < shifts; i++) {
+        array.InsertAt(T(i), 0);
+        array.RemoveAt(0);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << name << ": рост " << std::chrono::duration_cast<std::chrono::milliseconds>(grown - start).count()
+              << "ms, сдвиги " << std::chrono::duration_cast<std::chrono::milliseconds>(end - grown).count() << "ms" << std::endl;
+}
+
+void BenchmarkDynamicArray() {
+    std::cout << "\n=== БЕНЧМАРК DYNAMIC ARRAY ===" << std::endl;
+
+    const int COUNT = 1000000;
+    const int SHIFTS = 200;
+    std::cout << COUNT << " элементов, " << SHIFTS << " вставок и удалений в начале" << std::endl;
+
+    MeasureDynamicArray<int>("int (memmove/realloc)", COUNT, SHIFTS);
+    MeasureDynamicArray<OpaqueValue<int>>("int (поэлементно)", COUNT, SHIFTS);
+    MeasureDynamicArray<std::complex<double>>("Complex (memmove/realloc)", COUNT, SHIFTS);
+    MeasureDynamicArray<OpaqueValue<std::complex<double>>>("Complex (поэлементно)", COUNT, SHIFTS);
+}
+
 void RunAllTests() {
     std::cout << "=== ЗАПУСК ВСЕХ ТЕСТОВ ===" << std::endl;
     TestDynamicArray();
@@ -1008,6 +1095,7 @@ void ShowMainMenu() {
     std::cout << "6. Запуск всех тестов" << std::endl;
     std::cout << "7. Демонстрация Map-Reduce" << std::endl;
     std::cout << "8. Демонстрация Slice" << std::endl;
+    std::cout << "9. Бенчмарк Dynamic Array" << std::endl;
     std::cout << "0. Выход" << std::endl;
     std::cout << "Выберите опцию: ";
 }
@@ -1027,6 +1115,7 @@ void RunUI() {
             case 6: RunAllTests(); break;
             case 7: DemoMapReduce(); break;
             case 8: DemoSlice(); break;
+            case 9: BenchmarkDynamicArray(); break;
             case 0: std::cout << "Выход..." << std::endl; break;
             default: std::cout << "Неверный выбор!" << std::endl;
         }